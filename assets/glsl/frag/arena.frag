@@ -0,0 +1,56 @@
+#version 430
+
+// Shades a StaticArena like blinn-phong.frag, or like the stock lambert shader without
+// materials, reading the material of every draw from a storage buffer.
+
+struct Material {
+	vec4 diffuseColor;
+	vec4 specularColor;
+	vec4 ambientColor;
+	vec4 emissionColor;
+	vec4 Ns;	// x only
+};
+
+layout(std430, binding = 1) readonly buffer Materials {
+	Material materials[];
+};
+
+uniform bool uMaterials;
+uniform bool uTextured;
+uniform sampler2D uTexture;
+
+in VertexData {
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+	vec2 texCoord;
+} vertexIn;
+
+flat in uint vMaterial;
+
+out vec4 fragColor;
+
+void main() {
+	vec3 normalDirection = normalize(vertexIn.normal);
+	vec3 lightDirection = vec3(0, 0, 1);
+	float lambert = max(dot(normalDirection, lightDirection), 0.0);
+
+	if (!uMaterials) {
+		vec4 color = vertexIn.color;
+		if (uTextured) {
+			color *= texture(uTexture, vertexIn.texCoord);
+		}
+		fragColor = color * vec4(vec3(lambert), 1.0);
+		return;
+	}
+
+	Material material = materials[vMaterial];
+	float specularCoefficient = 0.0;
+	if (lambert > 0.0) {
+		vec3 viewDirection = normalize(-vertexIn.position.xyz);
+		vec3 halfDirection = normalize(lightDirection + viewDirection);
+		specularCoefficient = pow(max(dot(normalDirection, halfDirection), 0.0), material.Ns.x);
+	}
+
+	fragColor = vec4(material.ambientColor + vec4(vec3(lambert), 1.0) * material.diffuseColor + specularCoefficient * material.specularColor);
+}
@@ -0,0 +1,49 @@
+#version 150
+
+// blinn-phong.frag reading the material from the loader's material buffer, so selecting a
+// mesh's material is a single uniform.
+
+#define MAX_MATERIALS 192	// MaxUniformMaterials in AssimpLoader.cpp
+
+struct Material {
+	vec4 diffuseColor;
+	vec4 specularColor;
+	vec4 ambientColor;
+	vec4 emissionColor;
+	vec4 Ns;	// x only
+};
+
+layout(std140) uniform Materials {
+	Material materials[MAX_MATERIALS];
+};
+
+uniform int materialIndex;
+
+in VertexData	{
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+} vertexIn;
+
+out vec4 fragColor;
+
+void main() {
+	Material material = materials[materialIndex];
+
+	// lighting calculations
+	vec3 normalDirection = normalize(vertexIn.normal);
+	vec3 lightDirection = vec3(0, 0, 1);
+
+	// Calculate coefficients.
+	float specularCoefficient = 0.0;
+	float lambert = max(dot(normalDirection, lightDirection), 0.0);
+
+	if(lambert > 0.0) {
+		vec3 viewDirection = normalize(-vertexIn.position.xyz);
+		vec3 halfDirection = normalize(lightDirection + viewDirection);
+		specularCoefficient = max(dot(normalDirection, halfDirection), 0.0);
+		specularCoefficient = pow(specularCoefficient, material.Ns.x);
+	}
+
+	fragColor = vec4(material.ambientColor + vec4(vec3(lambert), 1.0)*material.diffuseColor + specularCoefficient*material.specularColor);
+}
@@ -0,0 +1,23 @@
+#version 150
+
+// lambert.frag modulated by the mesh texture, for the instanced shaders of textured meshes;
+// matches the stock lambert().color().texture() shader of AssimpLoader::draw().
+
+uniform sampler2D uTex0;
+
+in VertexData	{
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+} vertexIn;
+
+in vec2 vTexCoord;
+
+out vec4 fragColor;
+
+void main(void) {
+    const vec3 lightDirection = vec3(0, 0, 1);
+    vec3 normalDirection = normalize(vertexIn.normal);
+    float lambert = max(0.0, dot(normalDirection,lightDirection));
+    fragColor = texture(uTex0, vTexCoord)*vertexIn.color*vec4(vec3(lambert), 1.0);
+}
@@ -0,0 +1,45 @@
+#version 430
+
+// Draws a StaticArena with glMultiDrawElementsIndirect: the base instance of every command is
+// its draw index, which selects the node transform and material of the mesh.
+
+uniform mat4 ciModelViewProjection;
+uniform mat4 ciModelView;
+uniform mat3 ciNormalMatrix;
+
+layout(std430, binding = 0) readonly buffer Transforms {
+	mat4 transforms[];
+};
+
+layout(std430, binding = 2) readonly buffer DrawMaterials {
+	uint drawMaterials[];
+};
+
+in vec4 ciPosition;
+in vec4 ciColor;
+in vec3 ciNormal;
+in vec2 ciTexCoord0;
+in float iDrawId;	// per command, through the base instance
+
+out VertexData {
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+	vec2 texCoord;
+} vertexOut;
+
+flat out uint vMaterial;
+
+void main(void) {
+	int drawId = int(iDrawId + 0.5);
+	mat4 transform = transforms[drawId];
+
+	vec4 position = transform * ciPosition;
+	gl_Position = ciModelViewProjection * position;
+	vertexOut.position = ciModelView * position;
+	// assumes uniformly scaled nodes; the fragment shader normalizes
+	vertexOut.normal = ciNormalMatrix * (mat3(transform) * ciNormal);
+	vertexOut.color = ciColor;
+	vertexOut.texCoord = ciTexCoord0;
+	vMaterial = drawMaterials[drawId];
+}
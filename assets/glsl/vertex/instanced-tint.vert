@@ -0,0 +1,34 @@
+#version 150
+
+// Instanced version of tint.vert: the tint color and ratio come from every instance, the ratio
+// being the alpha of iTint.
+
+uniform mat4 ciModelViewProjection;
+uniform mat4 ciModelView;
+uniform mat3 ciNormalMatrix;
+uniform mat4 uNodeMatrix;	// derived transform of the mesh's node
+
+in vec4 ciPosition;
+in vec4 ciColor;
+in vec3 ciNormal;
+in vec2 ciTexCoord0;
+in mat4 iModelMatrix;	// per instance
+in vec4 iTint;			// per instance
+
+out VertexData {
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+} vertexOut;
+
+out vec2 vTexCoord;	// read by lambert-texture.frag only
+
+void main(void) {
+	mat4 modelMatrix = iModelMatrix * uNodeMatrix;
+	vec4 position = modelMatrix * ciPosition;
+	gl_Position = ciModelViewProjection * position;
+	vertexOut.position = ciModelView * position;
+	vertexOut.normal = ciNormalMatrix * (mat3(modelMatrix) * ciNormal);
+	vTexCoord = ciTexCoord0;
+	vertexOut.color = mix(ciColor, vec4(iTint.rgb, ciColor.a), iTint.a);
+}
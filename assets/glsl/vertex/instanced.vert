@@ -0,0 +1,35 @@
+#version 150
+
+// Drop-in for passthrough.vert used by AssimpLoader::drawInstanced(): every instance is placed
+// by its own model matrix, applied after the node transform and before the current model-view
+// matrix.
+
+uniform mat4 ciModelViewProjection;
+uniform mat4 ciModelView;
+uniform mat3 ciNormalMatrix;
+uniform mat4 uNodeMatrix;	// derived transform of the mesh's node
+
+in vec4 ciPosition;
+in vec4 ciColor;
+in vec3 ciNormal;
+in vec2 ciTexCoord0;
+in mat4 iModelMatrix;	// per instance
+
+out VertexData {
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+} vertexOut;
+
+out vec2 vTexCoord;	// read by lambert-texture.frag only
+
+void main(void) {
+	mat4 modelMatrix = iModelMatrix * uNodeMatrix;
+	vec4 position = modelMatrix * ciPosition;
+	gl_Position = ciModelViewProjection * position;
+	vertexOut.position = ciModelView * position;
+	// assumes uniformly scaled instances; the fragment shaders normalize
+	vertexOut.normal = ciNormalMatrix * (mat3(modelMatrix) * ciNormal);
+	vTexCoord = ciTexCoord0;
+	vertexOut.color = ciColor;
+}
@@ -0,0 +1,51 @@
+#version 150
+
+// Plays back a VertexAnimation: positions and normals are fetched per vertex from the baked
+// textures instead of the mesh attributes, so no skinning happens on the CPU.
+
+uniform mat4 ciModelViewProjection;
+uniform mat4 ciModelView;
+uniform mat3 ciNormalMatrix;
+
+uniform sampler2D uVatPositions;
+uniform sampler2D uVatNormals;
+uniform bool uVatHasNormals;	// VertexAnimation::hasNormals(); ciNormal is used otherwise
+uniform int uVatTextureWidth;	// VertexAnimation::getTextureWidth()
+uniform int uVatRowsPerFrame;	// VertexAnimation::getRowsPerFrame()
+uniform int uVatNumFrames;		// VertexAnimation::getNumFrames()
+uniform int uVatVertexOffset;	// VertexAnimation::getMeshOffset() of the drawn mesh
+uniform float uVatFrame;		// playback position in frames: time * VertexAnimation::getSampleRate()
+
+in vec4 ciPosition;
+in vec4 ciColor;
+in vec3 ciNormal;
+
+out VertexData {
+	vec4 position;
+	vec3 normal;
+	vec4 color;
+} vertexOut;
+
+ivec2 vatTexel(int frame) {
+	int texel = uVatVertexOffset + gl_VertexID;
+	return ivec2(texel % uVatTextureWidth, frame * uVatRowsPerFrame + texel / uVatTextureWidth);
+}
+
+void main(void) {
+	// loop over the clip; the last frame equals the end of the clip, so it wraps to frame 0
+	float frame = mod(uVatFrame, float(max(uVatNumFrames - 1, 1)));
+	int frame0 = int(floor(frame));
+	int frame1 = min(frame0 + 1, uVatNumFrames - 1);
+	float blend = frame - float(frame0);
+
+	vec3 position = mix(texelFetch(uVatPositions, vatTexel(frame0), 0).xyz, texelFetch(uVatPositions, vatTexel(frame1), 0).xyz, blend);
+	vec3 normal = ciNormal;
+	if (uVatHasNormals) {
+		normal = mix(texelFetch(uVatNormals, vatTexel(frame0), 0).xyz, texelFetch(uVatNormals, vatTexel(frame1), 0).xyz, blend);
+	}
+
+	gl_Position = ciModelViewProjection * vec4(position, 1.0);
+	vertexOut.position = ciModelView * vec4(position, 1.0);
+	vertexOut.normal = ciNormalMatrix * normalize(normal);
+	vertexOut.color = ciColor;
+}
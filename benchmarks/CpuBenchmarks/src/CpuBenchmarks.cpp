@@ -0,0 +1,621 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "cinder/Timer.h"
+
+#include "AssimpLoader.h"
+#include "Node.h"
+#include "NodeHierarchy.h"
+#include "Skinning.h"
+#include "ThreadPool.h"
+#include "UpdateScheduler.h"
+
+using namespace std;
+using namespace ci;
+using namespace sitara::assimp;
+
+//! CPU hot paths of the loader, without a window or GL context: models are loaded with
+// enableGpuResources(false), so nothing is uploaded.  The scaled variants multiply the
+// vertices or bones of the real meshes, or build deep node chains, to show how the paths grow.
+
+namespace {
+    //! Loads the example model \a file without GL resources.
+    AssimpLoaderRef loadModel(const std::string& file) {
+        AssimpLoaderRef model = AssimpLoader::create();
+        model->setFilename(fs::path(SITARA_ASSIMP_PATH) / "examples" / "BasicAssimpExample" / "assets" / file);
+        model->enableGpuResources(false);
+        model->preloadModel();
+        model->postloadModel();
+        return model;
+    }
+
+    //! Returns the example model \a file, loaded once without GL resources.
+    AssimpLoaderRef getModel(const std::string& file) {
+        static std::map<std::string, AssimpLoaderRef> models;
+        AssimpLoaderRef& model = models[file];
+        if (!model) {
+            model = loadModel(file);
+        }
+        return model;
+    }
+
+    //! Returns the thread counts 1, 2, 4, ... up to and including the number of cores.
+    std::vector<int64_t> getThreadCounts() {
+        const int64_t numCores = static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<int64_t> counts;
+        for (int64_t threads = 1; threads < numCores; threads *= 2) {
+            counts.push_back(threads);
+        }
+        counts.push_back(numCores);
+        return counts;
+    }
+
+    //! Adds getThreadCounts() as the only argument.
+    void threadCounts(benchmark::internal::Benchmark* benchmark) {
+        for (int64_t threads : getThreadCounts()) {
+            benchmark->Arg(threads);
+        }
+    }
+
+    //! Returns the speedup of \a seconds over the one thread run of the same \a key, which
+    // has to run first.
+    double getSpeedup(const std::string& key, size_t numThreads, double seconds) {
+        static std::map<std::string, double> serialSeconds;
+        if (numThreads == 1) {
+            serialSeconds[key] = seconds;
+        }
+        auto it = serialSeconds.find(key);
+        return (it != serialSeconds.end() && seconds > 0.0) ? it->second / seconds : 0.0;
+    }
+
+    //! Returns a copy of \a source with its vertices, faces and bone weights repeated \a factor times.
+    std::unique_ptr<aiMesh> scaleMesh(const aiMesh* source, unsigned factor) {
+        const unsigned numVertices = source->mNumVertices;
+        auto mesh = std::make_unique<aiMesh>();
+        mesh->mName = source->mName;
+        mesh->mPrimitiveTypes = source->mPrimitiveTypes;
+        mesh->mMaterialIndex = source->mMaterialIndex;
+        mesh->mNumVertices = numVertices * factor;
+        mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+        if (source->HasNormals()) {
+            mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+        }
+        if (source->HasTextureCoords(0)) {
+            mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+            mesh->mNumUVComponents[0] = source->mNumUVComponents[0];
+        }
+        if (source->HasVertexColors(0)) {
+            mesh->mColors[0] = new aiColor4D[mesh->mNumVertices];
+        }
+        for (unsigned k = 0; k < factor; ++k) {
+            for (unsigned v = 0; v < numVertices; ++v) {
+                mesh->mVertices[k * numVertices + v] = source->mVertices[v];
+                if (mesh->mNormals)
+                    mesh->mNormals[k * numVertices + v] = source->mNormals[v];
+                if (mesh->mTextureCoords[0])
+                    mesh->mTextureCoords[0][k * numVertices + v] = source->mTextureCoords[0][v];
+                if (mesh->mColors[0])
+                    mesh->mColors[0][k * numVertices + v] = source->mColors[0][v];
+            }
+        }
+
+        mesh->mNumFaces = source->mNumFaces * factor;
+        mesh->mFaces = new aiFace[mesh->mNumFaces];
+        for (unsigned k = 0; k < factor; ++k) {
+            for (unsigned f = 0; f < source->mNumFaces; ++f) {
+                const aiFace& sourceFace = source->mFaces[f];
+                aiFace& face = mesh->mFaces[k * source->mNumFaces + f];
+                face.mNumIndices = sourceFace.mNumIndices;
+                face.mIndices = new unsigned[face.mNumIndices];
+                for (unsigned i = 0; i < face.mNumIndices; ++i) {
+                    face.mIndices[i] = sourceFace.mIndices[i] + k * numVertices;
+                }
+            }
+        }
+
+        if (source->HasBones()) {
+            mesh->mNumBones = source->mNumBones;
+            mesh->mBones = new aiBone*[mesh->mNumBones];
+            for (unsigned b = 0; b < source->mNumBones; ++b) {
+                const aiBone* sourceBone = source->mBones[b];
+                aiBone* bone = new aiBone();
+                bone->mName = sourceBone->mName;
+                bone->mOffsetMatrix = sourceBone->mOffsetMatrix;
+                bone->mNumWeights = sourceBone->mNumWeights * factor;
+                bone->mWeights = new aiVertexWeight[bone->mNumWeights];
+                for (unsigned k = 0; k < factor; ++k) {
+                    for (unsigned w = 0; w < sourceBone->mNumWeights; ++w) {
+                        bone->mWeights[k * sourceBone->mNumWeights + w] =
+                            aiVertexWeight(sourceBone->mWeights[w].mVertexId + k * numVertices, sourceBone->mWeights[w].mWeight);
+                    }
+                }
+                mesh->mBones[b] = bone;
+            }
+        }
+        return mesh;
+    }
+
+    //! Returns the skinned mesh of seymour.dae with the most vertices.
+    const aiMesh* getSkinnedMesh() {
+        AssimpLoaderRef model = getModel("seymour.dae");
+        const aiMesh* skinned = nullptr;
+        for (size_t n = 0; n < model->getNumMeshes(); ++n) {
+            const aiMesh* mesh = model->getMesh(n)->mAiMesh;
+            if (mesh->HasBones() && (!skinned || mesh->mNumVertices > skinned->mNumVertices)) {
+                skinned = mesh;
+            }
+        }
+        return skinned;
+    }
+
+    //! Poses every node but the root of \a model differently for every \a frame, so every bone
+    // moves.
+    void poseNodes(const AssimpLoaderRef& model, int frame) {
+        NodeHierarchyRef hierarchy = model->getNodeHierarchy();
+        std::vector<NodePose>& poses = hierarchy->beginPose();
+        for (size_t i = 1; i < poses.size(); ++i) {
+            poses[i].mOrientation = hierarchy->getInitialPose(i).mOrientation *
+                                    glm::angleAxis(0.2f * std::sin(frame * 0.1f + i), vec3(0, 0, 1));
+        }
+        hierarchy->commitPose();
+    }
+
+    //! The node of the baseline tree, before NodeHierarchy: every node holds its parent and
+    // children, setters invalidate the subtree recursively and derived values are pulled up the
+    // parent chain recursively.  Kept as the reference for the chain benchmarks.
+    struct RecursiveNode {
+        RecursiveNode* mParent = nullptr;
+        std::vector<RecursiveNode*> mChildren;
+        quat mOrientation;
+        vec3 mPosition;
+        vec3 mScale = vec3(1);
+        mutable quat mDerivedOrientation;
+        mutable vec3 mDerivedPosition;
+        mutable vec3 mDerivedScale;
+        mutable mat4 mDerivedTransform;
+        mutable bool mNeedsUpdate = true;
+
+        void setOrientation(const quat& q) {
+            mOrientation = glm::normalize(q);
+            requestUpdate();
+        }
+
+        void setPosition(const vec3& position) {
+            mPosition = position;
+            requestUpdate();
+        }
+
+        void setScale(const vec3& scale) {
+            mScale = scale;
+            requestUpdate();
+        }
+
+        void requestUpdate() {
+            mNeedsUpdate = true;
+            for (RecursiveNode* child : mChildren) {
+                child->requestUpdate();
+            }
+        }
+
+        void update() const {
+            if (mParent) {
+                if (mParent->mNeedsUpdate) {
+                    mParent->update();
+                }
+                mDerivedOrientation = mOrientation * mParent->mDerivedOrientation;
+                mDerivedScale = mParent->mDerivedScale * mScale;
+                mDerivedPosition = (mParent->mDerivedScale * mPosition) * mParent->mDerivedOrientation;
+                mDerivedPosition += mParent->mDerivedPosition;
+            } else {
+                mDerivedOrientation = mOrientation;
+                mDerivedPosition = mPosition;
+                mDerivedScale = mScale;
+            }
+            mNeedsUpdate = false;
+        }
+
+        const mat4& getDerivedTransform() const {
+            if (mNeedsUpdate) {
+                update();
+            }
+            mDerivedTransform = glm::scale(mDerivedScale);
+            mDerivedTransform *= mat4(mDerivedOrientation);
+            mDerivedTransform *= glm::translate(mDerivedPosition);
+            return mDerivedTransform;
+        }
+    };
+
+    //! Returns a chain of \a depth baseline nodes posed like makeChain().
+    std::vector<std::unique_ptr<RecursiveNode>> makeRecursiveChain(size_t depth) {
+        std::vector<std::unique_ptr<RecursiveNode>> chain;
+        for (size_t i = 0; i < depth; ++i) {
+            chain.push_back(std::make_unique<RecursiveNode>());
+            chain.back()->mPosition = vec3(0, 1, 0);
+            chain.back()->mOrientation = glm::angleAxis(0.01f, vec3(0, 0, 1));
+            if (i > 0) {
+                chain[i]->mParent = chain[i - 1].get();
+                chain[i - 1]->mChildren.push_back(chain[i].get());
+            }
+        }
+        return chain;
+    }
+
+    //! Returns a chain of \a depth nodes, every node the child of the one before.
+    NodeHierarchyRef makeChain(size_t depth) {
+        NodeHierarchyRef hierarchy = NodeHierarchy::create();
+        hierarchy->reserve(depth);
+        for (size_t i = 0; i < depth; ++i) {
+            size_t node = hierarchy->addNode("node" + std::to_string(i), static_cast<int>(i) - 1);
+            hierarchy->setPosition(node, vec3(0, 1, 0));
+            hierarchy->setOrientation(node, glm::angleAxis(0.01f, vec3(0, 0, 1)));
+        }
+        return hierarchy;
+    }
+}
+
+//! fromAssimp(const aiMesh*) on every mesh of the model; argument: vertex scale factor.
+static void BM_FromAssimp(benchmark::State& state, const std::string& file) {
+    AssimpLoaderRef model = getModel(file);
+    std::vector<std::unique_ptr<aiMesh>> meshes;
+    size_t numVertices = 0;
+    for (size_t n = 0; n < model->getNumMeshes(); ++n) {
+        meshes.push_back(scaleMesh(model->getMesh(n)->mAiMesh, static_cast<unsigned>(state.range(0))));
+        numVertices += meshes.back()->mNumVertices;
+    }
+
+    for (auto _ : state) {
+        for (const auto& mesh : meshes) {
+            benchmark::DoNotOptimize(fromAssimp(mesh.get()));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numVertices);
+}
+BENCHMARK_CAPTURE(BM_FromAssimp, seymour, std::string("seymour.dae"))->Arg(1)->Arg(10)->ArgName("scale")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FromAssimp, astroboy, std::string("astroboy_walk.dae"))->Arg(1)->Arg(10)->ArgName("scale")->Unit(benchmark::kMicrosecond);
+
+//! calculateDimensions(), the recursive calculateBoundingBoxForNode() walk over the scene.
+static void BM_BoundingBox(benchmark::State& state, const std::string& file) {
+    AssimpLoaderRef model = getModel(file);
+    for (auto _ : state) {
+        model->calculateDimensions();
+        benchmark::DoNotOptimize(model->getBoundingBox());
+    }
+}
+BENCHMARK_CAPTURE(BM_BoundingBox, seymour, std::string("seymour.dae"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_BoundingBox, astroboy, std::string("astroboy_walk.dae"))->Unit(benchmark::kMicrosecond);
+
+//! update() of the walk cycle at 60 frames per second without skinning: sampling the channels,
+// writing the node poses, updateMeshes() and the animated bounds.
+static void BM_UpdateAnimation(benchmark::State& state) {
+    AssimpLoaderRef model = getModel("astroboy_walk.dae");
+    if (model->getNumAnimations() == 0) {
+        state.SkipWithError("astroboy_walk.dae has no animation");
+        return;
+    }
+    model->disableSkinning();
+    model->enableAnimation();
+    model->setAnimation(0);
+    const double duration = model->getAnimationDuration(0);
+
+    int frame = 0;
+    for (auto _ : state) {
+        model->setTime(std::fmod(++frame / 60.0, duration));
+        model->update();
+    }
+    model->disableAnimation();
+}
+BENCHMARK(BM_UpdateAnimation)->Unit(benchmark::kMicrosecond);
+
+//! update() with every bone moving: the skeleton palette, updateSkinning() and updateMeshes().
+// Arguments: whether skinning is enabled, so the difference is the cost of skinning.
+static void BM_UpdateSkinning(benchmark::State& state, const std::string& file) {
+    AssimpLoaderRef model = getModel(file);
+    model->disableAnimation();
+    model->enableSkinning(state.range(0) != 0);
+
+    int frame = 0;
+    for (auto _ : state) {
+        poseNodes(model, ++frame);
+        model->update();
+    }
+    model->disableSkinning();
+}
+BENCHMARK_CAPTURE(BM_UpdateSkinning, seymour, std::string("seymour.dae"))->Arg(0)->Arg(1)->ArgName("skinning")->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_UpdateSkinning, astroboy, std::string("astroboy_walk.dae"))->Arg(0)->Arg(1)->ArgName("skinning")->Unit(benchmark::kMicrosecond);
+
+//! BM_UpdateSkinning with skinning on and the loader's ThreadPool skinning the meshes in
+// chunks.  Argument: threads of the pool, from 1 (no pool) to the number of cores.
+static void BM_UpdateSkinningThreads(benchmark::State& state, const std::string& file) {
+    const size_t numThreads = static_cast<size_t>(state.range(0));
+    AssimpLoaderRef model = getModel(file);
+    model->disableAnimation();
+    model->enableSkinning();
+    model->setThreadPool(numThreads > 1 ? ThreadPool::create(numThreads) : nullptr);
+
+    int frame = 0;
+    Timer timer(true);
+    for (auto _ : state) {
+        poseNodes(model, ++frame);
+        model->update();
+    }
+    const double seconds = timer.getSeconds() / state.iterations();
+    model->setThreadPool(nullptr);
+    model->disableSkinning();
+    state.counters["speedup"] = getSpeedup("update skinning " + file, numThreads, seconds);
+}
+BENCHMARK_CAPTURE(BM_UpdateSkinningThreads, seymour, std::string("seymour.dae"))->Apply(threadCounts)->ArgName("threads")->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_UpdateSkinningThreads, astroboy, std::string("astroboy_walk.dae"))->Apply(threadCounts)->ArgName("threads")->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+//! skinVertices() on the largest skinned mesh of seymour.dae scaled up, split into the
+// chunks of AssimpLoader::updateSkinning() and run on a ThreadPool.  Arguments: vertex scale
+// factor and threads of the pool.
+static void BM_SkinVerticesThreads(benchmark::State& state) {
+    const aiMesh* skinned = getSkinnedMesh();
+    if (!skinned) {
+        state.SkipWithError("seymour.dae has no skinned mesh");
+        return;
+    }
+    std::unique_ptr<aiMesh> mesh = scaleMesh(skinned, static_cast<unsigned>(state.range(0)));
+    const size_t numThreads = static_cast<size_t>(state.range(1));
+    const BoneInfluences influences = buildBoneInfluences(mesh.get());
+    std::vector<aiMatrix4x4> palette(mesh->mNumBones);
+    for (size_t b = 0; b < palette.size(); ++b) {
+        aiMatrix4x4::RotationZ(0.01f * b, palette[b]);
+    }
+    std::vector<float> positions(mesh->mNumVertices * 3);
+    std::vector<float> normals(mesh->mNumVertices * 3);
+
+    const size_t chunkSize = 4096;
+    const size_t numChunks = (mesh->mNumVertices + chunkSize - 1) / chunkSize;
+    ThreadPoolRef pool = ThreadPool::create(numThreads);
+    Timer timer(true);
+    for (auto _ : state) {
+        pool->parallelFor(numChunks, [&](size_t chunk) {
+            const size_t first = chunk * chunkSize;
+            skinVertices(influences, palette.data(), mesh->mVertices, mesh->mNormals, positions.data(),
+                         mesh->mNormals ? normals.data() : nullptr, first, std::min(chunkSize, mesh->mNumVertices - first));
+        });
+        benchmark::ClobberMemory();
+    }
+    const double seconds = timer.getSeconds() / state.iterations();
+    state.counters["speedup"] = getSpeedup("skin vertices " + std::to_string(state.range(0)), numThreads, seconds);
+    state.SetItemsProcessed(state.iterations() * mesh->mNumVertices);
+}
+BENCHMARK(BM_SkinVerticesThreads)
+    ->ArgsProduct({{10, 50}, getThreadCounts()})
+    ->ArgNames({"scale", "threads"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+//! skinVertices() on the largest skinned mesh of seymour.dae.  Arguments: kernel (0 scalar,
+// 1 SSE, 2 AVX), vertex scale factor and bone scale factor; with more bones every vertex
+// keeps its influences but reads them from a palette that many times larger.
+static void BM_SkinVertices(benchmark::State& state) {
+    const SkinningKernel kernel = static_cast<SkinningKernel>(state.range(0));
+    if (!isSkinningKernelSupported(kernel)) {
+        state.SkipWithError("kernel not supported by this CPU");
+        return;
+    }
+    const aiMesh* skinned = getSkinnedMesh();
+    if (!skinned) {
+        state.SkipWithError("seymour.dae has no skinned mesh");
+        return;
+    }
+
+    std::unique_ptr<aiMesh> mesh = scaleMesh(skinned, static_cast<unsigned>(state.range(1)));
+    const uint32_t boneScale = static_cast<uint32_t>(state.range(2));
+    BoneInfluences influences = buildBoneInfluences(mesh.get());
+    for (size_t i = 0; i < influences.mBones.size(); ++i) {
+        influences.mBones[i] = influences.mBones[i] * boneScale + static_cast<uint32_t>(i / MaxBoneInfluences) % boneScale;
+    }
+    std::vector<aiMatrix4x4> palette(mesh->mNumBones * boneScale);
+    for (size_t b = 0; b < palette.size(); ++b) {
+        aiMatrix4x4 translation;
+        aiMatrix4x4::RotationZ(0.01f * b, palette[b]);
+        palette[b] = aiMatrix4x4::Translation(aiVector3D(0.0f, 0.001f * b, 0.0f), translation) * palette[b];
+    }
+
+    std::vector<float> positions(mesh->mNumVertices * 3);
+    std::vector<float> normals(mesh->mNumVertices * 3);
+    for (auto _ : state) {
+        skinVertices(kernel, influences, palette.data(), mesh->mVertices, mesh->mNormals, positions.data(),
+                     mesh->mNormals ? normals.data() : nullptr, 0, mesh->mNumVertices);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * mesh->mNumVertices);
+}
+BENCHMARK(BM_SkinVertices)
+    ->ArgsProduct({{0, 1, 2}, {1, 10}, {1, 10}})
+    ->ArgNames({"kernel", "scale", "bones"})
+    ->Unit(benchmark::kMicrosecond);
+
+//! UpdateScheduler::update() of 16 independent astroboy loaders playing the walk cycle at
+// different times.  Argument: threads of the scheduler's pool, from 1 to the number of cores.
+// The efficiency counter is UpdateScheduler::Stats::getEfficiency(), 1.0 for perfect scaling;
+// the speedup is the wall time per batch on one thread divided by the current one.
+static void BM_UpdateScheduler(benchmark::State& state) {
+    const size_t numThreads = static_cast<size_t>(state.range(0));
+    static std::vector<AssimpLoaderRef> loaders;
+    if (loaders.empty()) {
+        for (int i = 0; i < 16; ++i) {
+            loaders.push_back(loadModel("astroboy_walk.dae"));
+        }
+    }
+    if (loaders.front()->getNumAnimations() == 0) {
+        state.SkipWithError("astroboy_walk.dae has no animation");
+        return;
+    }
+    for (const AssimpLoaderRef& loader : loaders) {
+        loader->enableSkinning();
+        loader->enableAnimation();
+        loader->setAnimation(0);
+    }
+    const double duration = loaders.front()->getAnimationDuration(0);
+    UpdateSchedulerRef scheduler = UpdateScheduler::create(numThreads);
+
+    int frame = 0;
+    double wallSeconds = 0.0;
+    double efficiency = 0.0;
+    for (auto _ : state) {
+        ++frame;
+        for (size_t i = 0; i < loaders.size(); ++i) {
+            loaders[i]->setTime(std::fmod(frame / 60.0 + i * 0.1, duration));
+        }
+        scheduler->update(loaders);
+        wallSeconds += scheduler->getLastStats().mWallSeconds;
+        efficiency += scheduler->getLastStats().getEfficiency();
+    }
+    for (const AssimpLoaderRef& loader : loaders) {
+        loader->disableAnimation();
+        loader->disableSkinning();
+    }
+
+    state.counters["efficiency"] = efficiency / state.iterations();
+    state.counters["speedup"] = getSpeedup("scheduler", numThreads, wallSeconds / state.iterations());
+    state.SetItemsProcessed(state.iterations() * loaders.size());
+}
+BENCHMARK(BM_UpdateScheduler)->Apply(threadCounts)->ArgName("threads")->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+//! AssimpNode::getDerivedTransform() of every node of a model after its root moved.
+static void BM_DerivedTransforms(benchmark::State& state, const std::string& file) {
+    AssimpLoaderRef model = getModel(file);
+    NodeHierarchyRef hierarchy = model->getNodeHierarchy();
+    std::vector<AssimpNodeRef> nodes;
+    for (size_t i = 0; i < hierarchy->getNumNodes(); ++i) {
+        nodes.push_back(model->getAssimpNode(static_cast<NodeHandle>(i)));
+    }
+    const quat initial = hierarchy->getOrientation(0);
+
+    int frame = 0;
+    for (auto _ : state) {
+        nodes.front()->setOrientation(initial * glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0)));
+        for (const AssimpNodeRef& node : nodes) {
+            benchmark::DoNotOptimize(node->getDerivedTransform());
+        }
+    }
+    nodes.front()->setOrientation(initial);
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK_CAPTURE(BM_DerivedTransforms, seymour, std::string("seymour.dae"))->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_DerivedTransforms, astroboy, std::string("astroboy_walk.dae"))->Unit(benchmark::kMicrosecond);
+
+//! The derived transform of the leaf of a chain of nodes after its root moved, which sweeps
+// the whole chain.  Argument: depth of the chain.
+static void BM_DerivedTransformChain(benchmark::State& state) {
+    NodeHierarchyRef hierarchy = makeChain(static_cast<size_t>(state.range(0)));
+    AssimpNode root(hierarchy, 0);
+    AssimpNode leaf(hierarchy, hierarchy->getNumNodes() - 1);
+
+    int frame = 0;
+    for (auto _ : state) {
+        root.setOrientation(glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0)));
+        benchmark::DoNotOptimize(leaf.getDerivedTransform());
+    }
+    state.SetItemsProcessed(state.iterations() * hierarchy->getNumNodes());
+}
+BENCHMARK(BM_DerivedTransformChain)->RangeMultiplier(8)->Range(8, 4096)->ArgName("depth")->Unit(benchmark::kMicrosecond);
+
+//! Moving one node in the middle of a deep chain invalidates only the nodes after it.
+static void BM_DerivedTransformChainMiddle(benchmark::State& state) {
+    NodeHierarchyRef hierarchy = makeChain(static_cast<size_t>(state.range(0)));
+    AssimpNode middle(hierarchy, hierarchy->getNumNodes() / 2);
+    AssimpNode leaf(hierarchy, hierarchy->getNumNodes() - 1);
+
+    int frame = 0;
+    for (auto _ : state) {
+        middle.setOrientation(glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0)));
+        benchmark::DoNotOptimize(leaf.getDerivedTransform());
+    }
+}
+BENCHMARK(BM_DerivedTransformChainMiddle)->RangeMultiplier(8)->Range(8, 4096)->ArgName("depth")->Unit(benchmark::kMicrosecond);
+
+//! BM_DerivedTransformChain on the baseline nodes.
+static void BM_DerivedTransformChainRecursive(benchmark::State& state) {
+    std::vector<std::unique_ptr<RecursiveNode>> chain = makeRecursiveChain(static_cast<size_t>(state.range(0)));
+
+    int frame = 0;
+    for (auto _ : state) {
+        chain.front()->setOrientation(glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0)));
+        benchmark::DoNotOptimize(chain.back()->getDerivedTransform());
+    }
+    state.SetItemsProcessed(state.iterations() * chain.size());
+}
+BENCHMARK(BM_DerivedTransformChainRecursive)->RangeMultiplier(8)->Range(8, 4096)->ArgName("depth")->Unit(benchmark::kMicrosecond);
+
+//! BM_DerivedTransformChainMiddle on the baseline nodes.
+static void BM_DerivedTransformChainMiddleRecursive(benchmark::State& state) {
+    std::vector<std::unique_ptr<RecursiveNode>> chain = makeRecursiveChain(static_cast<size_t>(state.range(0)));
+
+    int frame = 0;
+    for (auto _ : state) {
+        chain[chain.size() / 2]->setOrientation(glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0)));
+        benchmark::DoNotOptimize(chain.back()->getDerivedTransform());
+    }
+}
+BENCHMARK(BM_DerivedTransformChainMiddleRecursive)->RangeMultiplier(8)->Range(8, 4096)->ArgName("depth")->Unit(benchmark::kMicrosecond);
+
+//! A frame of animation on a chain: every node gets a new position, orientation and scale, as
+// updateAnimation() writes them, then the leaf is read.  Written through beginPose() and
+// commitPose(), which invalidate once.  Argument: depth of the chain.
+static void BM_PoseChain(benchmark::State& state) {
+    NodeHierarchyRef hierarchy = makeChain(static_cast<size_t>(state.range(0)));
+    AssimpNode leaf(hierarchy, hierarchy->getNumNodes() - 1);
+
+    int frame = 0;
+    for (auto _ : state) {
+        const quat orientation = glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0));
+        std::vector<NodePose>& poses = hierarchy->beginPose();
+        for (NodePose& pose : poses) {
+            pose.mPosition = vec3(0, 1, 0);
+            pose.mOrientation = orientation;
+            pose.mScale = vec3(1);
+        }
+        hierarchy->commitPose();
+        benchmark::DoNotOptimize(leaf.getDerivedTransform());
+    }
+    state.SetItemsProcessed(state.iterations() * hierarchy->getNumNodes());
+}
+BENCHMARK(BM_PoseChain)->RangeMultiplier(8)->Range(8, 4096)->ArgName("depth")->Unit(benchmark::kMicrosecond);
+
+//! BM_PoseChain on the baseline nodes, three setters per node; every one of them flags the
+// whole subtree below the node.
+static void BM_PoseChainRecursive(benchmark::State& state) {
+    std::vector<std::unique_ptr<RecursiveNode>> chain = makeRecursiveChain(static_cast<size_t>(state.range(0)));
+
+    int frame = 0;
+    for (auto _ : state) {
+        const quat orientation = glm::angleAxis(0.01f * ++frame, vec3(0, 1, 0));
+        for (const auto& node : chain) {
+            node->setPosition(vec3(0, 1, 0));
+            node->setOrientation(orientation);
+            node->setScale(vec3(1));
+        }
+        benchmark::DoNotOptimize(chain.back()->getDerivedTransform());
+    }
+    state.SetItemsProcessed(state.iterations() * chain.size());
+}
+BENCHMARK(BM_PoseChainRecursive)->RangeMultiplier(8)->Range(8, 4096)->ArgName("depth")->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,400 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <set>
+
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Camera.h"
+#include "cinder/Json.h"
+#include "cinder/Log.h"
+#include "AssimpLoader.h"
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+using namespace sitara::assimp;
+
+//! Loads every model in turn and runs update() and draw() on it for a fixed number of frames,
+// then writes the CPU time of every stage and the draws and state changes per frame as JSON.
+// Built against a headless Cinder (see the README) it needs no display, so it runs on CI
+// machines with Mesa's llvmpipe.
+//
+//   HeadlessBenchmark [--frames N] [--warmup N] [--output file.json] [--model path]...
+//                     [--static-batching] [--static-merging] [--texture-packing] [--no-skinning]
+class HeadlessBenchmarkApp : public App {
+public:
+    static void prepareSettings(Settings* settings);
+
+    void setup() override;
+    void update() override;
+    void draw() override;
+
+private:
+    //! Milliseconds spent in one stage, one sample per measured frame.
+    struct Samples {
+        std::vector<double> mTimes;
+
+        JsonTree toJson(const std::string& key) const;
+    };
+
+    struct Result {
+        fs::path mPath;
+        std::string mError; /// why the model couldn't be loaded, if it couldn't
+        double mPreloadMs = 0;
+        double mPostloadMs = 0;
+        size_t mNumMeshes = 0;
+        size_t mNumVertices = 0;
+        size_t mNumAnimations = 0;
+
+        Samples mUpdate;
+        Samples mUpdateGpu;
+        Samples mDraw;
+        Samples mFinish; /// waiting for the GPU, so CPU stages aren't hidden behind a full command queue
+        Samples mFrame;
+        RenderQueue::Stats mRenderStats; /// summed over the measured frames
+        uint64_t mUploadBytes = 0; /// summed over the measured frames
+        std::vector<size_t> mCachedBatches; /// after every custom shader swap
+    };
+
+    void parseArgs();
+    void collectModels();
+    void loadModel(Result& result);
+    void checkShaderSwaps(Result& result);
+    void finishModel();
+    void writeResults() const;
+
+    static double getMilliseconds(std::chrono::steady_clock::time_point start);
+
+    int mNumFrames = 300;
+    int mNumWarmupFrames = 10;
+    fs::path mOutputPath = "benchmark.json";
+    std::vector<fs::path> mModelPaths;
+    bool mStaticBatching = false;
+    bool mStaticMerging = false;
+    bool mTexturePacking = false;
+    bool mSkinning = true;
+
+    std::vector<Result> mResults;
+    size_t mCurrent = 0;
+    int mFrame = 0;
+    double mUpdateMs = 0;
+    AssimpLoaderRef mLoader;
+    CameraPersp mCamera;
+};
+
+void HeadlessBenchmarkApp::prepareSettings(Settings* settings) {
+    settings->setWindowSize(1280, 720);
+    // frames are timed, not paced
+    settings->disableFrameRate();
+}
+
+void HeadlessBenchmarkApp::setup() {
+    // the stock shaders, and the textures of the example models
+    addAssetDirectory(fs::path(SITARA_ASSIMP_PATH) / "assets");
+    addAssetDirectory(fs::path(SITARA_ASSIMP_PATH) / "examples" / "BasicAssimpExample" / "assets");
+
+    parseArgs();
+    if (mModelPaths.empty()) {
+        collectModels();
+    }
+    for (const fs::path& path : mModelPaths) {
+        Result result;
+        result.mPath = path;
+        mResults.push_back(result);
+    }
+
+    CI_LOG_I("Benchmarking " << mResults.size() << " models for " << mNumFrames << " frames on "
+                             << reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    if (mResults.empty()) {
+        writeResults();
+        quit();
+    }
+}
+
+void HeadlessBenchmarkApp::parseArgs() {
+    const std::vector<std::string>& args = getCommandLineArgs();
+    for (size_t i = 1; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if (arg == "--frames" && hasValue) {
+            mNumFrames = std::max(1, std::stoi(args[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            mNumWarmupFrames = std::max(0, std::stoi(args[++i]));
+        } else if (arg == "--output" && hasValue) {
+            mOutputPath = args[++i];
+        } else if (arg == "--model" && hasValue) {
+            mModelPaths.push_back(args[++i]);
+        } else if (arg == "--static-batching") {
+            mStaticBatching = true;
+        } else if (arg == "--static-merging") {
+            mStaticMerging = true;
+        } else if (arg == "--texture-packing") {
+            mTexturePacking = true;
+        } else if (arg == "--no-skinning") {
+            mSkinning = false;
+        } else {
+            CI_LOG_W("Ignoring argument " << arg);
+        }
+    }
+}
+
+void HeadlessBenchmarkApp::collectModels() {
+    // every file of assets/models assimp can read, and the example's .dae files
+    Assimp::Importer importer;
+    std::set<fs::path> paths;
+    for (const auto& entry : fs::directory_iterator(fs::path(SITARA_ASSIMP_PATH) / "assets" / "models")) {
+        if (entry.is_regular_file() && importer.IsExtensionSupported(entry.path().extension().string())) {
+            paths.insert(entry.path());
+        }
+    }
+    for (const auto& entry : fs::directory_iterator(fs::path(SITARA_ASSIMP_PATH) / "examples" / "BasicAssimpExample" / "assets")) {
+        if (entry.is_regular_file() && entry.path().extension() == ".dae") {
+            paths.insert(entry.path());
+        }
+    }
+    mModelPaths.assign(paths.begin(), paths.end());
+}
+
+void HeadlessBenchmarkApp::loadModel(Result& result) {
+    CI_LOG_I("Loading " << result.mPath.string());
+    try {
+        mLoader = AssimpLoader::create();
+        mLoader->setFilename(result.mPath);
+        mLoader->enableStaticBatching(mStaticBatching);
+        mLoader->enableTexturePacking(mTexturePacking);
+
+        auto start = std::chrono::steady_clock::now();
+        mLoader->preloadModel();
+        result.mPreloadMs = getMilliseconds(start);
+        start = std::chrono::steady_clock::now();
+        mLoader->postloadModel();
+        result.mPostloadMs = getMilliseconds(start);
+    } catch (const std::exception& exc) {
+        CI_LOG_E("Couldn't load " << result.mPath.string() << ": " << exc.what());
+        result.mError = exc.what();
+        mLoader.reset();
+        return;
+    }
+
+    result.mNumMeshes = mLoader->getNumMeshes();
+    result.mNumAnimations = mLoader->getNumAnimations();
+    for (size_t n = 0; n < mLoader->getNumMeshes(); ++n) {
+        if (mLoader->getTriMesh(n)) {
+            result.mNumVertices += mLoader->getTriMesh(n)->getNumVertices();
+        }
+    }
+
+    mLoader->enableSkinning(mSkinning);
+    mLoader->enableAnimation(result.mNumAnimations > 0);
+    mLoader->enableStaticMerging(mStaticMerging);
+
+    const AxisAlignedBox bounds = mLoader->getBoundingBox();
+    const float size = std::max(glm::length(bounds.getSize()), 0.001f);
+    mCamera.setPerspective(60.0f, getWindowAspectRatio(), size * 0.01f, size * 10.0f);
+    mCamera.lookAt(bounds.getCenter() + vec3(0.0f, 0.25f, 1.0f) * size, bounds.getCenter(), vec3(0, 1, 0));
+    mFrame = 0;
+}
+
+void HeadlessBenchmarkApp::update() {
+    if (mCurrent >= mResults.size()) {
+        return;
+    }
+    Result& result = mResults[mCurrent];
+    if (!mLoader) {
+        loadModel(result);
+        if (!mLoader) {
+            finishModel();
+            return;
+        }
+    }
+
+    // a fixed time step, so every run samples the same poses
+    if (result.mNumAnimations > 0) {
+        const double duration = mLoader->getAnimationDuration(mLoader->getAnimation());
+        mLoader->setTime(duration > 0 ? std::fmod(mFrame / 60.0, duration) : 0.0);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    mLoader->update();
+    mUpdateMs = getMilliseconds(start);
+}
+
+void HeadlessBenchmarkApp::draw() {
+    gl::clear(Color::black());
+    if (!mLoader) {
+        return;
+    }
+    Result& result = mResults[mCurrent];
+
+    gl::ScopedDepth depth(true);
+    gl::ScopedMatrices matrices;
+    gl::setMatrices(mCamera);
+
+    mLoader->resetUploadBytes();
+    auto frameStart = std::chrono::steady_clock::now();
+    mLoader->updateGpu();
+    const double updateGpuMs = getMilliseconds(frameStart);
+
+    auto start = std::chrono::steady_clock::now();
+    mLoader->draw();
+    const double drawMs = getMilliseconds(start);
+
+    start = std::chrono::steady_clock::now();
+    glFinish();
+    const double finishMs = getMilliseconds(start);
+    const double frameMs = mUpdateMs + getMilliseconds(frameStart);
+
+    if (mFrame >= mNumWarmupFrames) {
+        result.mUpdate.mTimes.push_back(mUpdateMs);
+        result.mUpdateGpu.mTimes.push_back(updateGpuMs);
+        result.mDraw.mTimes.push_back(drawMs);
+        result.mFinish.mTimes.push_back(finishMs);
+        result.mFrame.mTimes.push_back(frameMs);
+
+        const RenderQueue::Stats& stats = mLoader->getRenderStats();
+        result.mRenderStats.mNumDraws += stats.mNumDraws;
+        result.mRenderStats.mNumProgramChanges += stats.mNumProgramChanges;
+        result.mRenderStats.mNumTextureChanges += stats.mNumTextureChanges;
+        result.mRenderStats.mNumCullChanges += stats.mNumCullChanges;
+        result.mRenderStats.mNumMaterialChanges += stats.mNumMaterialChanges;
+        result.mUploadBytes += mLoader->getUploadBytes();
+    }
+
+    if (++mFrame >= mNumWarmupFrames + mNumFrames) {
+        checkShaderSwaps(result);
+        finishModel();
+    }
+}
+
+void HeadlessBenchmarkApp::checkShaderSwaps(Result& result) {
+    // every swap replaces the previous custom shader, so the batches cached for it have to go
+    // and their number has to stay flat
+    const int numSwaps = 4;
+    mLoader->enableCustomShader();
+    for (int i = 0; i < numSwaps; ++i) {
+        mLoader->setCustomShader(gl::GlslProg::create(loadAsset("glsl/vertex/passthrough.vert"), loadAsset("glsl/frag/lambert.frag")));
+        mLoader->draw();
+        result.mCachedBatches.push_back(mLoader->getNumCachedBatches());
+    }
+    mLoader->enableCustomShader(false);
+    if (result.mCachedBatches.back() > result.mCachedBatches.front()) {
+        CI_LOG_E(result.mPath.string() << ": cached batches grew from " << result.mCachedBatches.front() << " to "
+                                       << result.mCachedBatches.back() << " over " << numSwaps << " shader swaps");
+    }
+}
+
+void HeadlessBenchmarkApp::finishModel() {
+    mLoader.reset();
+    if (++mCurrent >= mResults.size()) {
+        writeResults();
+        quit();
+    }
+}
+
+JsonTree HeadlessBenchmarkApp::Samples::toJson(const std::string& key) const {
+    JsonTree tree = JsonTree::makeObject(key);
+    if (mTimes.empty()) {
+        return tree;
+    }
+
+    std::vector<double> sorted = mTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double time : sorted) {
+        sum += time;
+    }
+    tree.pushBack(JsonTree("mean", sum / sorted.size()));
+    tree.pushBack(JsonTree("median", sorted[sorted.size() / 2]));
+    tree.pushBack(JsonTree("p95", sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)]));
+    tree.pushBack(JsonTree("min", sorted.front()));
+    tree.pushBack(JsonTree("max", sorted.back()));
+    return tree;
+}
+
+void HeadlessBenchmarkApp::writeResults() const {
+    JsonTree settings = JsonTree::makeObject("settings");
+    settings.pushBack(JsonTree("frames", mNumFrames));
+    settings.pushBack(JsonTree("warmupFrames", mNumWarmupFrames));
+    settings.pushBack(JsonTree("staticBatching", mStaticBatching));
+    settings.pushBack(JsonTree("staticMerging", mStaticMerging));
+    settings.pushBack(JsonTree("texturePacking", mTexturePacking));
+    settings.pushBack(JsonTree("skinning", mSkinning));
+
+    JsonTree models = JsonTree::makeArray("models");
+    for (const Result& result : mResults) {
+        JsonTree model = JsonTree::makeObject();
+        model.pushBack(JsonTree("path", result.mPath.string()));
+        if (!result.mError.empty()) {
+            model.pushBack(JsonTree("error", result.mError));
+            models.pushBack(model);
+            continue;
+        }
+        model.pushBack(JsonTree("meshes", static_cast<uint64_t>(result.mNumMeshes)));
+        model.pushBack(JsonTree("vertices", static_cast<uint64_t>(result.mNumVertices)));
+        model.pushBack(JsonTree("animations", static_cast<uint64_t>(result.mNumAnimations)));
+        model.pushBack(JsonTree("preloadMs", result.mPreloadMs));
+        model.pushBack(JsonTree("postloadMs", result.mPostloadMs));
+
+        JsonTree cpu = JsonTree::makeObject("cpuMs");
+        cpu.pushBack(result.mUpdate.toJson("update"));
+        cpu.pushBack(result.mUpdateGpu.toJson("updateGpu"));
+        cpu.pushBack(result.mDraw.toJson("draw"));
+        cpu.pushBack(result.mFinish.toJson("finish"));
+        cpu.pushBack(result.mFrame.toJson("frame"));
+        model.pushBack(cpu);
+
+        // the loader's own counts of what it submitted, averaged over the measured frames
+        const double frames = static_cast<double>(std::max<size_t>(1, result.mFrame.mTimes.size()));
+        const RenderQueue::Stats& stats = result.mRenderStats;
+        JsonTree perFrame = JsonTree::makeObject("perFrame");
+        perFrame.pushBack(JsonTree("drawCalls", stats.mNumDraws / frames));
+        perFrame.pushBack(JsonTree("programChanges", stats.mNumProgramChanges / frames));
+        perFrame.pushBack(JsonTree("textureChanges", stats.mNumTextureChanges / frames));
+        perFrame.pushBack(JsonTree("cullChanges", stats.mNumCullChanges / frames));
+        perFrame.pushBack(JsonTree("materialChanges", stats.mNumMaterialChanges / frames));
+        perFrame.pushBack(JsonTree("stateChanges", stats.getNumStateChanges() / frames));
+        perFrame.pushBack(JsonTree("uploadBytes", result.mUploadBytes / frames));
+        model.pushBack(perFrame);
+
+        JsonTree cachedBatches = JsonTree::makeArray("cachedBatchesPerShaderSwap");
+        for (size_t numBatches : result.mCachedBatches) {
+            cachedBatches.pushBack(JsonTree("", static_cast<uint64_t>(numBatches)));
+        }
+        model.pushBack(cachedBatches);
+
+        models.pushBack(model);
+    }
+
+    JsonTree root;
+    root.pushBack(JsonTree("renderer", std::string(reinterpret_cast<const char*>(glGetString(GL_RENDERER)))));
+    root.pushBack(JsonTree("glVersion", std::string(reinterpret_cast<const char*>(glGetString(GL_VERSION)))));
+    root.pushBack(settings);
+    root.pushBack(models);
+    root.write(mOutputPath);
+    CI_LOG_I("Wrote " << mOutputPath.string());
+}
+
+double HeadlessBenchmarkApp::getMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+CINDER_APP(HeadlessBenchmarkApp, RendererGl, &HeadlessBenchmarkApp::prepareSettings)
@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 //* 5.0
@@ -31,9 +36,15 @@
 #include "cinder/Stream.h"
 #include "cinder/AxisAlignedBox.h"
 #include "cinder/gl/gl.h"
+#include "cinder/gl/Ubo.h"
 
 #include "Node.h"
 #include "AssimpMesh.h"
+#include "ThreadPool.h"
+#include "PoseCache.h"
+#include "RenderQueue.h"
+#include "StaticArena.h"
+#include "TextureAtlas.h"
 
 namespace sitara {
 	namespace assimp {
@@ -86,12 +97,22 @@ namespace sitara {
 			return std::string( s.data );
 		}
 
+		//! Converts the vertices, normals, first texture coordinates, first colors and triangles
+		// of \a mesh into a ci::TriMesh.  Throws AssimpLoaderExc on faces with more than three
+		// indices.
+		ci::TriMeshRef fromAssimp( const aiMesh *mesh );
+
 		class AssimpLoaderExc : public std::exception
 		{
 			public:
 				AssimpLoaderExc( const std::string &log ) throw()
 				{
+#if defined( _MSC_VER )
 					strncpy_s( mMessage, log.c_str(), 512 );
+#else
+					strncpy( mMessage, log.c_str(), 512 );
+					mMessage[ 512 ] = 0;
+#endif
 				}
 
 				virtual const char* what() const throw()
@@ -114,81 +135,249 @@ namespace sitara {
 				//! GL Shaders and conversion to ci::TriMesh
                 void postloadModel();
 
-				//! Updates model animation and skinning.
+				//! Updates model animation and skinning.  Touches no GL state, so loaders may be
+				// updated from worker threads; see UpdateScheduler.
 				void update();
-
-                //! Draws mesh by index
+				//! Uploads the vertices changed by update() to the GPU; must be called on the GL
+				// thread.  draw() and drawMesh() upload anything still pending themselves.
+				void updateGpu();
+				//! Returns the number of vertex bytes uploaded to the GPU since the last call to
+				// resetUploadBytes().
+				uint64_t getUploadBytes() const { return mUploadBytes; }
+				void resetUploadBytes() { mUploadBytes = 0; }
+
+                //! Draws mesh by index, wherever draw() draws it
 				bool drawMesh(int index);
-                //! Draws mesh by name
+                //! Draws mesh by name, wherever draw() draws it
 				bool drawMesh(const std::string& name);
-				//! Draws all meshes in the model.
+				//! Draws all meshes in the model, every mesh placed by the derived transform of its node.
+				// Skinned meshes aren't, their vertices are in model space already.  Earlier versions
+				// drew every mesh untransformed; see "Upgrading" in the README.
 				void draw();
+				//! Draws the model once for every matrix in \a transforms, which is applied before the
+				// current model matrix, with one instanced draw call per mesh.  \a tints optionally
+				// gives every instance a color, blended into the vertex colors by its alpha like
+				// tint.vert; it has to be empty or as long as \a transforms.  Shaders assigned with
+				// setCustomShader() or setMeshShader() have to read the per instance attributes
+				// "iModelMatrix" (mat4) and "iTint" (vec4) themselves, see instanced.vert, and are given
+				// the node transform as "uNodeMatrix" if they declare it.  Without
+				// materials, textured meshes are sampled like in draw(); the phong shaders ignore textures.
+				void drawInstanced( const std::vector< ci::mat4 > &transforms, const std::vector< ci::ColorAf > &tints = std::vector< ci::ColorAf >() );
 
 				//! Returns the bounding box of the static, not skinned mesh.
 				ci::AxisAlignedBox getBoundingBox() const { return mBoundingBox; }
+				//! Recomputes getBoundingBox() from the meshes of the scene placed by their nodes;
+				// postloadModel() calls it.
+				void calculateDimensions();
+				//! Returns a conservative bounding box of the meshes as of the last update(), in the
+				// coordinates they are drawn in.  Skinned meshes are bounded by transforming
+				// per-bone boxes computed at load, so the box may be looser than the vertices.
+				// Displacement by morph targets isn't included.
+				const ci::AxisAlignedBox &getAnimatedBoundingBox() const { return mAnimatedBoundingBox; }
+				//! Returns the animated bounding box of the \a n'th mesh; see getAnimatedBoundingBox().
+				const ci::AxisAlignedBox &getAnimatedBoundingBox( size_t n ) const { return mModelMeshes[ n ]->mAnimatedBounds; }
+
+				//! Returns the handle of the node called \a name, or InvalidNodeHandle.  Resolve names
+				// once and use the handle overloads below for constant-time access.
+				NodeHandle findNode( const std::string &name ) const;
 
 				//! Sets the orientation of this node via a quaternion.
 				void setNodeOrientation( const std::string &name, const ci::quat &rot );
+				//! Sets the orientation of the node \a node via a quaternion.
+				void setNodeOrientation( NodeHandle node, const ci::quat &rot );
 				//! Returns a quaternion representing the orientation of the node called \a name.
 				ci::quat getNodeOrientation( const std::string &name );
+				//! Returns a quaternion representing the orientation of the node \a node.
+				ci::quat getNodeOrientation( NodeHandle node ) const;
 
 				//! Returns the node called \a name.
 				AssimpNodeRef getAssimpNode( const std::string &name );
 				//! Returns the node called \a name.
 				const AssimpNodeRef getAssimpNode( const std::string &name ) const;
+				//! Returns the node \a node.
+				AssimpNodeRef getAssimpNode( NodeHandle node );
+				//! Returns the node \a node.
+				const AssimpNodeRef getAssimpNode( NodeHandle node ) const;
+
+				//! Returns the node hierarchy of the model; use its beginPose()/commitPose() to pose many
+				// nodes at once.
+				NodeHierarchyRef getNodeHierarchy() { return mHierarchy; }
 
 				//! Returns the total number of meshes contained by the node called \a name.
 				size_t getAssimpNodeNumMeshes( const std::string &name );
+				//! Returns the total number of meshes contained by the node \a node.
+				size_t getAssimpNodeNumMeshes( NodeHandle node );
 				//! Returns the \a n'th cinder::TriMesh contained by the node called \a name.
 				ci::TriMeshRef getAssimpNodeMesh( const std::string &name, size_t n = 0 );
 				//! Returns the \a n'th cinder::TriMesh contained by the node called \a name.
 				const ci::TriMeshRef getAssimpNodeMesh( const std::string &name, size_t n = 0 ) const;
+				//! Returns the \a n'th cinder::TriMesh contained by the node \a node.
+				ci::TriMeshRef getAssimpNodeMesh( NodeHandle node, size_t n = 0 );
 
 				//! Returns the texture of the \a n'th mesh in the node called \a name.
 				ci::gl::Texture2dRef &getAssimpNodeTexture( const std::string &name, size_t n = 0 );
 				//! Returns the texture of the \a n'th mesh in the node called \a name.
 				const ci::gl::Texture2dRef &getAssimpNodeTexture( const std::string &name, size_t n = 0 ) const;
+				//! Returns the texture of the \a n'th mesh in the node \a node.
+				ci::gl::Texture2dRef &getAssimpNodeTexture( NodeHandle node, size_t n = 0 );
 
 				//! Returns the material of the \a n'th mesh in the node called \a name.
 				//sitara::assimp::Material& getAssimpNodeMaterial(const std::string& name, size_t n = 0);
 				//! Returns the material of the \a n'th mesh in the node called \a name.
 				//const sitara::assimp::Material& getAssimpNodeMaterial(const std::string& name, size_t n = 0) const;
 
-				//! Returns all node names in the model in a std::vector as std::string's.
-				const std::vector< std::string > &getNodeNames() { return mNodeNames; }
+				//! Returns all node names in the model in a std::vector as std::string's; empty
+				// before postloadModel().
+				const std::vector< std::string > &getNodeNames() const;
 
 				//! Setter and getter for setting a custom shader program.  To use this program, you'll need to
 				// call `enableCustomShader()`!
                 void setCustomShader(ci::gl::GlslProgRef program) {
                     mCustomShaderProgram = program;
+                    invalidateRenderQueue();
                 }
                 ci::gl::GlslProgRef getCustomShader() { return mCustomShaderProgram; }
 
 				//! Enables the usage of a custom shader during draw; disables all other draw options!
 				// If you enable this, you're on your own!
-                void enableCustomShader(bool enable = true) { mCustomShaderEnabled = enable; }
+                void enableCustomShader(bool enable = true) { mCustomShaderEnabled = enable; invalidateRenderQueue(); }
 				//! Disables the usage of a custom shader
-                void disableCustomShader() { mCustomShaderEnabled = false; }
+                void disableCustomShader() { enableCustomShader(false); }
+
+				//! Draws the \a n'th mesh with \a shader, which takes precedence over the custom,
+				// material and stock shaders.  Pass null to go back to the loader's shader.
+				void setMeshShader( size_t n, ci::gl::GlslProgRef shader ) { mModelMeshes[ n ]->mShader = shader; mStaticArena.reset(); invalidateRenderQueue(); }
+				ci::gl::GlslProgRef getMeshShader( size_t n ) const { return mModelMeshes[ n ]->mShader; }
 
 				//! Enables/disables the usage of materials during draw.
-				void enableMaterials( bool enable = true ) { mMaterialsEnabled = enable; }
+				void enableMaterials( bool enable = true ) { mMaterialsEnabled = enable; invalidateRenderQueue(); }
 				//! Disables the usage of materials during draw.
-				void disableMaterials() { mMaterialsEnabled = false; }
+				void disableMaterials() { enableMaterials( false ); }
 
 				//! Enables/disables the usage of textures during draw.
-				void enableTextures( bool enable = true ) { mTexturesEnabled = enable; }
+				void enableTextures( bool enable = true ) { mTexturesEnabled = enable; invalidateRenderQueue(); }
 				//! Disables the usage of textures during draw.
-				void disableTextures() { mTexturesEnabled = false; }
+				void disableTextures() { enableTextures( false ); }
+
+				//! Enables/disables static batching at load: the meshes of nodes no animation moves,
+				// that are neither skinned nor morphed, are transformed into the space of the root
+				// node and merged into one mesh per material, drawn at the root node.  getNumMeshes(),
+				// hideMesh() and drawMesh() keep working on the original meshes through the ranges of
+				// the merged ones.  Pose edits of the batched nodes, other than of the root, have no
+				// effect on their meshes anymore.  Has to be set before postloadModel().
+				void enableStaticBatching( bool enable = true ) { mStaticBatchingEnabled = enable; }
+				bool isStaticBatchingEnabled() const { return mStaticBatchingEnabled; }
+				//! Returns the meshes merged by static batching, attached to the root node.
+				const std::vector< AssimpMeshRef > &getBatchedMeshes() const { return mBatchedMeshes; }
+
+				//! Outcome of texture packing.
+				struct TexturePackingStats {
+					size_t mNumImages = 0; /// distinct diffuse images of the model
+					size_t mNumPackedImages = 0;
+					size_t mNumPages = 0;
+					float mOccupancy = 0; /// fraction of the atlas pages covered by images
+					size_t mNumBindsBefore = 0; /// binds per frame of the packed meshes before packing, one per mesh
+					size_t mNumBindsAfter = 0; /// binds per frame of the packed meshes with sorted draws, one per page
+					size_t getNumBindsSaved() const { return mNumBindsBefore - mNumBindsAfter; }
+				};
+
+				//! Enables/disables texture packing at load: diffuse images no larger than an atlas
+				// page, whose meshes' texture coordinates stay within [0, 1], are packed into
+				// pages of \a atlasSize pixels and the meshes' texture coordinates remapped into
+				// them.  Has to be set before postloadModel().
+				void enableTexturePacking( bool enable = true, int atlasSize = 2048 ) { mTexturePackingEnabled = enable; mAtlasSize = atlasSize; }
+				bool isTexturePackingEnabled() const { return mTexturePackingEnabled; }
+				TextureAtlasRef getTextureAtlas() const { return mTextureAtlas; }
+				const TexturePackingStats &getTexturePackingStats() const { return mTexturePackingStats; }
+
+				//! Enables/disables creating the GL resources of the model -- textures, shaders and the
+				// material buffer -- in postloadModel(); vertex buffers are only ever created by the
+				// first updateGpu() or draw call.  Without them a model can be loaded,
+				// animated and skinned without a GL context, e.g. by tools and benchmarks;
+				// updateGpu() does nothing and the draw functions must not be called.  Has to be set before
+				// postloadModel().
+				void enableGpuResources( bool enable = true ) { mGpuResourcesEnabled = enable; }
+				bool isGpuResourcesEnabled() const { return mGpuResourcesEnabled; }
+
+				//! Makes draw() pack the static meshes -- neither skinned nor morphed, without a mesh
+				// shader -- into one shared vertex and index buffer, drawn with a few
+				// glMultiDrawElementsIndirect calls on GL 4.3, or a loop over the packed meshes
+				// otherwise.  Meshes are placed by their nodes like in draw(), from a storage buffer.  Has
+				// no effect while a custom shader is enabled.
+				void enableStaticMerging( bool enable = true ) { mStaticMergingEnabled = enable; invalidateRenderQueue(); }
+				void disableStaticMerging() { enableStaticMerging( false ); }
+				bool isStaticMergingEnabled() const { return mStaticMergingEnabled; }
+				//! Returns the packed static meshes, built by the first draw() after enableStaticMerging().
+				StaticArenaRef getStaticArena() const { return mStaticArena; }
+
+				//! Returns the distinct materials of the model, one per aiMaterial used by a mesh and
+				// one per material edited differently since.
+				const std::vector< Material > &getMaterials() const { return mMaterials; }
+				//! Returns the uniform buffer holding getMaterials() in the std140 layout of
+				// blinn-phong-ubo.frag, or null if the model has too many materials; the phong
+				// shaders then get the material of every mesh as separate uniforms.
+				ci::gl::UboRef getMaterialBuffer() const { return mMaterialUbo; }
+
+				//! Returns the number of batches the meshes keep for the shaders they were drawn with;
+				// batches of shaders replaced since are dropped when draw() or drawInstanced() next
+				// rebuild their queues.
+				size_t getNumCachedBatches() const;
+				//! Returns the draws and state changes of the last draw(), drawInstanced() or drawMesh().
+				const RenderQueue::Stats &getRenderStats() const { return mRenderStats; }
+				//! Makes the next draw() sort the meshes again and refresh the material buffer and the
+				// static arena; needed after replacing a mesh's texture or material directly.
+				void invalidateRenderQueue() { mRenderQueueDirty = true; mInstancedQueueDirty = true; mMaterialsDirty = true; mStaticArena.reset(); }
+
+				//! Sets the pool used to skin meshes in parallel; without a pool, skinning runs on the
+				// calling thread.  Several loaders may share a pool, including one driven by an
+				// UpdateScheduler.
+				void setThreadPool( ThreadPoolRef pool ) { mThreadPool = pool; }
+				ThreadPoolRef getThreadPool() const { return mThreadPool; }
+
+				//! Shares sampled animation poses and skeleton palettes with other loaders of the
+				// same model through \a cache.  \a modelKey identifies the model and defaults to
+				// the file path.  Animation time is quantized to the cache's time quantum.  Loaders
+				// sharing a key are assumed to leave the nodes the clip doesn't animate alone; once
+				// a node is posed otherwise -- setNodeOrientation(), AssimpNode setters or the
+				// NodeHierarchy -- the loader computes its own palette.
+				void setPoseCache( PoseCacheRef cache, const std::string &modelKey = "" );
+				PoseCacheRef getPoseCache() const { return mPoseCache; }
 
 				//! Enables/disables skinning, when the model's bones distort the vertices.
 				void enableSkinning( bool enable = true );
 				//! Disables skinning, when the model's bones distort the vertices.
 				void disableSkinning() { enableSkinning( false ); }
+				bool isSkinningEnabled() const { return mSkinningEnabled; }
+
+				//! Enables/disables sparse skinning: when only some bones of a mesh moved, only the
+				// vertices they influence are skinned again.  Costs one list of vertices per bone.
+				void enableSparseSkinning( bool enable = true );
+				bool isSparseSkinningEnabled() const { return mSparseSkinningEnabled; }
+				//! Fraction of a mesh's vertices above which sparse skinning falls back to skinning
+				// the whole mesh, 0.5 by default.
+				void setSparseSkinningThreshold( float fraction ) { mSparseSkinningThreshold = fraction; }
+				float getSparseSkinningThreshold() const { return mSparseSkinningThreshold; }
+
+				//! Makes this loader skin with \a kernel; without one, the process-wide
+				// sitara::assimp::getSkinningKernel() is used.  Unlike the process-wide setting this
+				// doesn't affect other loaders, e.g. ones updated on other threads.
+				void setSkinningKernel( std::optional< SkinningKernel > kernel ) { mSkinningKernel = kernel; }
+				std::optional< SkinningKernel > getSkinningKernel() const { return mSkinningKernel; }
+
+				//! Returns the number of morph targets (blend shapes) of the \a n'th mesh.
+				size_t getNumMorphTargets( size_t n ) const { return mModelMeshes[ n ]->mMorphTargets.size(); }
+				//! Returns the name of morph target \a target of the \a n'th mesh.
+				const std::string &getMorphTargetName( size_t n, size_t target ) const { return mModelMeshes[ n ]->mMorphTargets[ target ].mName; }
+				//! Sets the weight of morph target \a target of the \a n'th mesh.  Morph channels of
+				// the active animation overwrite the weights of the meshes they drive.
+				void setMorphWeight( size_t n, size_t target, float weight );
+				float getMorphWeight( size_t n, size_t target ) const { return mModelMeshes[ n ]->mMorphWeights[ target ]; }
 
 				//! Enables/disables animation.
 				void enableAnimation( bool enable = true ) { mAnimationEnabled = enable; }
 				//! Disables animation.
 				void disableAnimation() { mAnimationEnabled = false; }
+				bool isAnimationEnabled() const { return mAnimationEnabled; }
 
 				//! Returns the total number of meshes in the model.
 				size_t getNumMeshes() const { return mModelMeshes.size(); }
@@ -205,6 +394,10 @@ namespace sitara {
 				ci::TriMeshRef getTriMesh( size_t n ) { return mModelMeshes[ n ]->mCachedTriMesh; }
 				//! Returns the \a n'th mesh in the model.
 				const ci::TriMeshRef getTriMesh( size_t n ) const { return mModelMeshes[ n ]->mCachedTriMesh; }
+				//! Returns the node whose derived transform places the \a n'th mesh in model space, or
+				// InvalidNodeHandle for skinned meshes, which are in model space already.  A mesh
+				// referenced by several nodes returns the first of them.
+				NodeHandle getMeshNode( size_t n ) const;
 
 				//! Returns the texture of the \a n'th mesh in the model.
 				ci::gl::Texture2dRef getTexture( size_t n ) { return mModelMeshes[ n ]->mTexture; }
@@ -220,12 +413,16 @@ namespace sitara {
 
 				//! Sets the current animation index to \a n.
 				void setAnimation( size_t n );
+				//! Returns the current animation index.
+				size_t getAnimation() const { return mAnimationIndex; }
 
 				//! Returns the duration of the \a n'th animation.
 				double getAnimationDuration( size_t n ) const;
 
 				//! Sets current animation time.
 				void setTime( double t );
+				//! Returns the current animation time.
+				double getTime() const { return mAnimationTime; }
 
 			private:
                 //! Constructs the class and nothing more -- you'll need to manually set filename,
@@ -237,45 +434,145 @@ namespace sitara {
                 AssimpLoader(const std::filesystem::path& filename);
 
 				void loadAllMeshes();
-				AssimpNodeRef loadNodes( const aiNode* nd, AssimpNodeRef parentRef = AssimpNodeRef() );
+				void resolveAnimationChannels();
+				void resolveSkeleton();
+				void batchStaticMeshes();
+				void packTextures();
+				AssimpNodeRef loadNodes( const aiNode* nd, int parentIndex = -1 );
 				AssimpMeshRef convertAiMesh( const aiMesh *mesh );
                 void drawMesh(AssimpMeshRef mesh);
+				RenderItem makeRenderItem( const AssimpMeshRef &assimpMeshRef, bool instanced = false, bool tinted = false );
+				void submitRenderItems( const RenderItem *items, size_t count, GLsizei numInstances = 0 );
+				void assignMaterialIndex( AssimpMesh *assimpMesh, unsigned aiMaterialIndex );
+				void createMaterialBuffer();
+				void updateMaterialBuffer();
+				void createShaders();
+				void applyMaterial( const ci::gl::GlslProgRef &shader, const AssimpMesh *assimpMesh );
+				void buildRenderQueue( const RenderQueueRef &queue, bool instanced, bool tinted );
+				void pruneBatches();
+				void createInstanceBuffers();
+				void appendInstanceBuffers( AssimpMesh *assimpMesh );
+				bool isStaticMergingActive() const;
+				void buildStaticArena();
+				void drawStaticArena( RenderQueue::Stats &stats );
+				void uploadMesh( AssimpMesh *assimpMesh );
+				ci::gl::BatchRef getBatch( AssimpMesh *assimpMesh, const ci::gl::GlslProgRef &shader );
 
-				void calculateDimensions();
 				void calculateBoundingBox( ci::vec3 *min, ci::vec3 *max );
 				void calculateBoundingBoxForNode( const aiNode *nd, aiVector3D *min, aiVector3D *max, aiMatrix4x4 *trafo );
 
 				void updateAnimation( size_t animationIndex, double currentTime );
+				void sampleAnimation( size_t animationIndex, double currentTime, std::vector< NodePose > &poses ) const;
+				void applyChannelPoses( size_t animationIndex, const std::vector< NodePose > &poses );
+				void updateMorphAnimation( size_t animationIndex, double currentTime );
+				bool updateAnimationFromCache();
+				void updateMorphTargets();
+				void updateSkeletonPalette();
 				void updateSkinning();
+				void addSparseSkinningJobs( AssimpMesh* assimpMesh );
 				void updateMeshes();
+				void updateAnimatedBounds();
+				void resetModel();
 
 				std::shared_ptr< Assimp::Importer > mImporterRef; // mScene will be destroyed along with the Importer object
 				ci::fs::path mFilePath; /// model path
 				const aiScene *mScene;
 
 				ci::AxisAlignedBox mBoundingBox;
+				ci::AxisAlignedBox mAnimatedBoundingBox;
 
+				NodeHierarchyRef mHierarchy; /// flattened node tree of the scene
 				AssimpNodeRef mRootNode; /// root node of scene
 
 				std::vector< AssimpNodeRef > mMeshNodes; /// nodes with meshes
 				std::vector< AssimpMeshRef > mModelMeshes; /// all meshes
 
-				std::vector< std::string > mNodeNames;
-				std::map< std::string, AssimpNodeRef > mNodeMap;
+				std::vector< AssimpNodeRef > mNodes; /// all nodes, indexed by NodeHandle
+				std::vector< std::vector< NodeHandle > > mAnimationChannelNodes; /// target node of every animation channel
+				std::vector< std::vector< std::vector< AssimpMesh* > > > mAnimationMorphMeshes; /// meshes of every morph channel
+				std::vector< float > mMorphChannelWeights; /// scratch weights of one morph channel
+
+				std::vector< NodeHandle > mSkeletonNodes; /// every node referenced by a bone, once
+				std::vector< aiMatrix4x4 > mSkeletonPalette; /// model space transform of every skeleton node
+				std::vector< uint64_t > mSkeletonVersions; /// pose version in which each palette entry last changed
+				uint64_t mPoseVersion; /// incremented by every palette update
 
 				std::vector<std::string> mAnimationNames;
 
 				bool mMaterialsEnabled;
 				bool mTexturesEnabled;
 				bool mSkinningEnabled;
+				bool mSparseSkinningEnabled;
+				float mSparseSkinningThreshold;
+				std::optional< SkinningKernel > mSkinningKernel;
 				bool mAnimationEnabled;
                 bool mCustomShaderEnabled;
 
 				ci::gl::GlslProgRef mCustomShaderProgram;
                 ci::gl::GlslProgRef mPhongShaderProgram;
+				ci::gl::GlslProgRef mInstancedShaderProgram; /// instanced.vert with lambert.frag
+				ci::gl::GlslProgRef mInstancedPhongShaderProgram;
+				ci::gl::GlslProgRef mInstancedTintShaderProgram; /// instanced-tint.vert with lambert.frag
+				ci::gl::GlslProgRef mInstancedTintPhongShaderProgram;
+				ci::gl::GlslProgRef mInstancedTextureShaderProgram; /// instanced.vert with lambert-texture.frag
+				ci::gl::GlslProgRef mInstancedTintTextureShaderProgram; /// instanced-tint.vert with lambert-texture.frag
 
 				size_t mAnimationIndex;
 				double mAnimationTime;
+
+				/// animation, time and resulting hierarchy version last written to the nodes, so a paused
+				/// animation isn't re-evaluated; any other pose edit changes the version
+				uint64_t mAppliedPoseVersion;
+				size_t mAppliedAnimationIndex;
+				double mAppliedAnimationTime;
+				std::vector< NodePose > mChannelPoses; /// sampled pose of every channel of the current animation
+				bool mCustomPose; /// nodes were posed other than by the animation
+
+				PoseCacheRef mPoseCache;
+				size_t mPoseCacheModel;
+				PoseCache::EntryRef mPoseCacheEntry; /// entry applied by the current update, if any
+
+				//! A range of vertices of one mesh, skinned as a single job.
+				struct SkinningJob {
+					AssimpMesh* mMesh;
+					size_t mFirst;
+					size_t mCount;
+				};
+
+				ThreadPoolRef mThreadPool;
+				uint64_t mUploadBytes;
+
+				RenderQueueRef mRenderQueue; /// every mesh, sorted by GL state
+				bool mRenderQueueDirty;
+				RenderQueue::Stats mRenderStats;
+				RenderQueueRef mInstancedQueue; /// like mRenderQueue, with the instanced shaders
+				bool mInstancedQueueDirty;
+				bool mInstancedQueueTinted;
+				ci::gl::VboRef mInstanceMatrixVbo; /// per instance model matrices, appended to every VboMesh
+				ci::gl::VboRef mInstanceTintVbo;
+
+				bool mStaticMergingEnabled;
+				StaticArenaRef mStaticArena;
+				ci::gl::GlslProgRef mArenaShaderProgram; /// arena.vert with arena.frag, GL 4.3 only
+
+				bool mStaticBatchingEnabled;
+				std::vector< AssimpMeshRef > mBatchedMeshes;
+				std::vector< std::unique_ptr< aiMesh > > mBatchedAiMeshes; /// geometry of mBatchedMeshes, owned by the loader
+
+				std::vector< Material > mMaterials; /// distinct materials, indexed by AssimpMesh::mMaterialIndex
+				std::unordered_map< unsigned, uint32_t > mMaterialIndices; /// entry of every aiMaterial in mMaterials
+				ci::gl::UboRef mMaterialUbo;
+				bool mMaterialsDirty; /// mesh materials may have been edited since mMaterials was built
+
+				bool mGpuResourcesEnabled;
+
+				bool mTexturePackingEnabled;
+				int mAtlasSize;
+				TextureAtlasRef mTextureAtlas;
+				TexturePackingStats mTexturePackingStats;
+				std::vector< SkinningJob > mSkinningJobs;
+				std::vector< AssimpMesh* > mMorphJobs; /// morphed meshes with changed weights, blended by updateMorphTargets()
+				std::vector< uint32_t > mSparseVertices; /// scratch list of the vertices moved by changed bones
 		};
 
 		typedef std::shared_ptr<AssimpLoader> AssimpLoaderRef;
@@ -19,13 +19,22 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 #include "assimp/mesh.h"
 
 #include "cinder/Cinder.h"
 #include "cinder/TriMesh.h"
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/Rect.h"
 #include "cinder/gl/Texture.h"
 #include "cinder/gl/Batch.h"
+#include "cinder/gl/VboMesh.h"
+
+#include "Skinning.h"
+#include "Morphing.h"
+#include "NodeHierarchy.h"
+#include "StreamingBuffer.h"
 
 namespace sitara {
 	namespace assimp {
@@ -40,6 +49,20 @@ namespace sitara {
 			ci::ColorAf mAmbient;
 			ci::ColorAf mEmission;
             float mShininess;
+
+			//! Returns whether \a other shades the same; name and face don't matter.
+			bool isSameShading( const Material &other ) const
+			{
+				return mDiffuse == other.mDiffuse && mSpecular == other.mSpecular && mAmbient == other.mAmbient &&
+					   mEmission == other.mEmission && mShininess == other.mShininess;
+			}
+		};
+
+		//! The part of a mesh merged by static batching that came from one mesh of one node.
+		struct MeshRange {
+			AssimpMesh* mMesh; /// original mesh, whose name and visibility the range keeps
+			uint32_t mFirstIndex;
+			uint32_t mNumIndices;
 		};
 
 		struct AssimpMesh {
@@ -47,21 +70,65 @@ namespace sitara {
 				const aiMesh *mAiMesh;
 
 				ci::gl::Texture2dRef mTexture = nullptr;
+				ci::fs::path mTexturePath; /// image mTexture was loaded from
+				ci::Rectf mAtlasRect = ci::Rectf( 0, 0, 1, 1 ); /// area of mTexture holding the image, after texture packing
 
 				Material mMaterial;
+				uint32_t mMaterialIndex = 0; /// entry of mMaterial in the loader's material buffer
 
 				std::vector< uint32_t > mIndices;
 
 				bool mTwoSided;
 
-				std::vector<aiVector3D > mAnimatedPos;
-				std::vector<aiVector3D > mAnimatedNorm;
+				BoneInfluences mBoneInfluences;
+				std::vector< uint32_t > mBonePaletteIndices; /// skeleton palette entry of every bone
+				std::vector< aiMatrix4x4 > mBoneOffsets; /// mesh-to-bone matrix of every bone
+				std::vector< aiMatrix4x4 > mBoneMatrices; /// skinning matrices, rebuilt when a bone moves
+				uint64_t mSkinnedVersion = 0; /// skeleton pose version of the last skinning pass
+				BoneVertexLists mBoneVertices; /// vertices of every bone, built for sparse skinning
+
+				std::vector< MorphTarget > mMorphTargets;
+				std::vector< float > mMorphWeights; /// current weight of every morph target
+				std::vector< float > mMorphedPositions; /// base mesh plus weighted targets, packed xyz and one float of padding
+				std::vector< float > mMorphedNormals;
+				bool mMorphDirty = false; /// weights changed since mMorphedPositions was blended
+
+				std::vector< uint32_t > mBoundedBones; /// bones influencing at least one vertex
+				std::vector< ci::AxisAlignedBox > mBoneBounds; /// bind pose vertices of every bounded bone, in bone space
+				ci::AxisAlignedBox mBindBounds; /// bounds of the undeformed mesh
+				ci::AxisAlignedBox mAnimatedBounds; /// bounds of the current vertices
+
+				//! Returns the undeformed input of skinning: the morphed vertices if the mesh has
+				// morph targets, otherwise the vertices of the aiMesh.
+				const aiVector3D* getSourcePositions() const
+				{
+					return mMorphTargets.empty() ? mAiMesh->mVertices : reinterpret_cast< const aiVector3D* >( mMorphedPositions.data() );
+				}
+				const aiVector3D* getSourceNormals() const
+				{
+					if ( !mAiMesh->HasNormals() )
+						return nullptr;
+					return mMorphTargets.empty() ? mAiMesh->mNormals : reinterpret_cast< const aiVector3D* >( mMorphedNormals.data() );
+				}
 
 				std::string mName;
+				NodeHandle mNode = InvalidNodeHandle; /// first node referencing the mesh, kept through static batching
                 bool mShowMesh = true;
+				ci::gl::GlslProgRef mShader; /// assigned with AssimpLoader::setMeshShader(), overrides the loader's shaders
+				bool mStaticMerged = false; /// drawn from the loader's StaticArena
+				std::vector< MeshRange > mRanges; /// original meshes of a mesh merged by static batching, in index order
+				AssimpMeshRef mBatch; /// merged mesh holding this mesh's geometry after static batching
 				ci::TriMeshRef mCachedTriMesh;
 				bool mValidCache;
 
+				ci::gl::VboMeshRef mVboMesh; /// GPU copy of mCachedTriMesh, created by the first upload
+				ci::gl::VboRef mPositionVbo; /// position stream of mVboMesh
+				ci::gl::VboRef mNormalVbo; /// normal stream of mVboMesh, null without normals
+				StreamingBufferRef mVertexStream; /// positions and normals of skinned or morphed meshes
+				std::vector< ci::gl::VboMeshRef > mStreamVboMeshes; /// one VboMesh per region of mVertexStream
+				std::unordered_map< ci::gl::GlslProgRef, std::vector< ci::gl::BatchRef > > mBatches; /// per shader the mesh was drawn with, one batch per VboMesh
+				bool mGpuDirty = false; /// positions or normals changed since the last upload
+
 		};
 	}
 }
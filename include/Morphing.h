@@ -0,0 +1,55 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "assimp/mesh.h"
+
+#include "Skinning.h"
+
+namespace sitara {
+	namespace assimp {
+		//! A morph target (blend shape) of a mesh, stored as displacements of only the vertices it
+		// moves.  Deltas are padded to four floats (x, y, z, 0) for the SIMD blend.
+		struct MorphTarget {
+			std::string mName;
+			std::vector<uint32_t> mVertices;
+			std::vector<float> mPositionDeltas;
+			//! Empty when the target doesn't change normals.
+			std::vector<float> mNormalDeltas;
+
+			size_t getNumVertices() const { return mVertices.size(); }
+		};
+
+		//! Converts \a animMesh, which assimp stores as a complete copy of \a mesh, into the
+		// displacements of the vertices that differ from \a mesh.
+		MorphTarget buildMorphTarget(const aiMesh* mesh, const aiAnimMesh* animMesh);
+
+		//! Adds \a weight times the deltas of \a target to \a positions and \a normals, which are
+		// packed xyz floats followed by at least one float of padding.  \a normals may be null.
+		// Uses SSE unless getSkinningKernel() is SkinningKernel::Scalar.
+		void applyMorphTarget(const MorphTarget& target, float weight, float* positions, float* normals);
+		//! Blends with SSE unless \a kernel is SkinningKernel::Scalar, so a loader's own kernel
+		// choice also applies to its morph targets.
+		void applyMorphTarget(SkinningKernel kernel, const MorphTarget& target, float weight, float* positions,
+							  float* normals);
+	}
+}
@@ -25,27 +25,26 @@
 #include "cinder/Quaternion.h"
 #include "cinder/Matrix.h"
 
+#include "NodeHierarchy.h"
+
 namespace sitara {
 	namespace assimp {
 		class AssimpNode;
 		typedef std::shared_ptr< AssimpNode > AssimpNodeRef;
 
-		// forward declare
-		class AssimpMesh;
-        typedef std::shared_ptr<AssimpMesh> AssimpMeshRef;
-
-
+		//! Handle to a single node of a NodeHierarchy.  All node data lives in the hierarchy's
+		// arrays; an AssimpNode only stores the hierarchy and the node's index into it.
 		class AssimpNode
 		{
 		public:
-			AssimpNode();
-			AssimpNode(const std::string& name);
+			AssimpNode(NodeHierarchyRef hierarchy, size_t index);
 			virtual ~AssimpNode() {};
 
-			void setParent(AssimpNodeRef parent);
+			//! Returns a handle to the parent node, or an empty AssimpNodeRef for a root node.
 			AssimpNodeRef getParent() const;
 
-			void addChild(AssimpNodeRef child);
+			NodeHierarchyRef getHierarchy() const;
+			size_t getIndex() const;
 
 			void setOrientation(const ci::quat& q);
 			const ci::quat& getOrientation() const;
@@ -82,63 +81,11 @@ namespace sitara {
 			void requestUpdate();
 
 		protected:
-			/// Shared pointer to parent AssimpNode.
-			AssimpNodeRef mParent;
-
-			/// Shared pointer vector holding the children.
-			std::vector< AssimpNodeRef > mChildren;
-
-			/// Name of this AssimpNode.
-			std::string mName;
-
-			/// The orientation of the AssimpNode relative to its parent.
-			ci::quat mOrientation;
-
-			/// The position of the AssimpNode relative to its parent.
-			ci::vec3 mPosition;
-
-			/// Scaling factor applied to this AssimpNode.
-			ci::vec3 mScale;
-
-			/// Stores whether this AssimpNode inherits orientation from its parent.
-			bool mInheritOrientation;
+			/// Hierarchy holding the node's data.
+			NodeHierarchyRef mHierarchy;
 
-			mutable bool mNeedsUpdate;
-
-			/// Stores whether this AssimpNode inherits scale from its parent
-			bool mInheritScale;
-
-			/** Cached combined orientation.
-				This member is the orientation derived by combining the
-				local transformations and those of it's parents.
-				*/
-			mutable ci::quat mDerivedOrientation;
-
-			/** Cached combined position.
-				This member is the position derived by combining the
-				local transformations and those of it's parents.
-				*/
-			mutable ci::vec3 mDerivedPosition;
-
-			/** Cached combined scale.
-				This member is the position derived by combining the
-				local transformations and those of it's parents.
-				*/
-			mutable ci::vec3 mDerivedScale;
-
-			/// The position to use as a base for keyframe animation.
-			ci::vec3 mInitialPosition;
-			/// The orientation to use as a base for keyframe animation.
-			ci::quat mInitialOrientation;
-			/// The scale to use as a base for keyframe animation.
-			ci::vec3 mInitialScale;
-
-			/// Cached derived transform as a 4x4 matrix
-			mutable ci::mat4 mDerivedTransform;
-            std::vector<AssimpMeshRef> mMeshes;
-
-			void update() const;
+			/// Index of this AssimpNode in mHierarchy.
+			size_t mIndex;
 		};
 	}
 }
-
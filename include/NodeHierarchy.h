@@ -0,0 +1,155 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cinder/Cinder.h"
+#include "cinder/Vector.h"
+#include "cinder/Quaternion.h"
+#include "cinder/Matrix.h"
+
+namespace sitara {
+	namespace assimp {
+		class NodeHierarchy;
+		typedef std::shared_ptr<NodeHierarchy> NodeHierarchyRef;
+
+		// forward declare
+		class AssimpMesh;
+		typedef std::shared_ptr<AssimpMesh> AssimpMeshRef;
+
+		//! Stable index of a node in its NodeHierarchy; resolve it once by name and use it for
+		// constant-time access afterwards.
+		typedef int NodeHandle;
+		const NodeHandle InvalidNodeHandle = -1;
+
+		//! Position, orientation and scale of a node.
+		struct NodePose {
+			ci::vec3 mPosition = ci::vec3(0);
+			ci::quat mOrientation = ci::quat(1, 0, 0, 0);
+			ci::vec3 mScale = ci::vec3(1);
+		};
+
+		//! The node tree of a model, stored as contiguous arrays in topological order (every
+		// parent comes before its children).  Derived transforms are recomputed lazily in a
+		// single linear sweep starting at the first invalidated node.
+		class NodeHierarchy
+		{
+		public:
+			static NodeHierarchyRef create();
+
+			//! Not copyable: the name table views the strings of this hierarchy.
+			NodeHierarchy(const NodeHierarchy&) = delete;
+			NodeHierarchy& operator=(const NodeHierarchy&) = delete;
+
+			//! Appends a node below \a parent (-1 for a root) and returns its index.  The parent
+			// has to be added before its children.
+			size_t addNode(const std::string& name, int parent = -1);
+
+			size_t getNumNodes() const { return mParents.size(); }
+
+			//! Returns the index of the parent of node \a i, or -1 for a root node.
+			int getParent(size_t i) const { return mParents[i]; }
+
+			void setName(size_t i, const std::string& name);
+			const std::string& getName(size_t i) const { return mNames[i]; }
+			//! Returns the names of all nodes, indexed by NodeHandle.
+			const std::vector<std::string>& getNames() const { return mNames; }
+
+			//! Returns the handle of the node called \a name, or InvalidNodeHandle.  When several
+			// nodes share a name the last one added wins.
+			NodeHandle findNode(const std::string_view& name) const;
+
+			//! Reserves room for \a numNodes nodes, avoiding rehashing of the name table while loading.
+			void reserve(size_t numNodes);
+
+			void setOrientation(size_t i, const ci::quat& q);
+			const ci::quat& getOrientation(size_t i) const { return mLocalPoses[i].mOrientation; }
+
+			void setPosition(size_t i, const ci::vec3& pos);
+			const ci::vec3& getPosition(size_t i) const { return mLocalPoses[i].mPosition; }
+
+			void setScale(size_t i, const ci::vec3& scale);
+			const ci::vec3& getScale(size_t i) const { return mLocalPoses[i].mScale; }
+
+			void setInheritOrientation(size_t i, bool inherit);
+			bool getInheritOrientation(size_t i) const { return mInheritOrientation[i] != 0; }
+
+			void setInheritScale(size_t i, bool inherit);
+			bool getInheritScale(size_t i) const { return mInheritScale[i] != 0; }
+
+			//! Sets position, orientation and scale of node \a i with a single invalidation.
+			void setLocalPose(size_t i, const NodePose& pose);
+			const NodePose& getLocalPose(size_t i) const { return mLocalPoses[i]; }
+
+			//! Starts a batched pose update and returns the local poses of all nodes for direct
+			// writing.  Orientations written this way have to be normalized.  Nothing is
+			// invalidated until commitPose().
+			std::vector<NodePose>& beginPose() { return mLocalPoses; }
+			//! Ends a batched pose update started with beginPose(); recomputes all derived
+			// transforms in one sweep.
+			void commitPose();
+
+			void setInitialState(size_t i) { mInitialPoses[i] = mLocalPoses[i]; }
+			void resetToInitialState(size_t i);
+			const NodePose& getInitialPose(size_t i) const { return mInitialPoses[i]; }
+
+			const ci::quat& getDerivedOrientation(size_t i) const;
+			const ci::vec3& getDerivedPosition(size_t i) const;
+			const ci::vec3& getDerivedScale(size_t i) const;
+			const ci::mat4& getDerivedTransform(size_t i) const;
+
+			std::vector<AssimpMeshRef>& getMeshes(size_t i) { return mMeshes[i]; }
+
+			//! Marks node \a i and, implicitly, all of its descendants for recomputation.
+			void invalidate(size_t i);
+			//! Returns a counter incremented by every change of a local pose, through the setters,
+			// invalidate() or commitPose(); compare it to detect pose edits.
+			uint64_t getVersion() const { return mVersion; }
+			//! Recomputes all invalidated derived transforms.
+			void update() const;
+
+		protected:
+			NodeHierarchy();
+
+			void rebuildNameIndex();
+
+			std::vector<int> mParents;
+			std::vector<std::string> mNames;
+			/// Hashed name table; keys view the strings stored in mNames, so names are stored once.
+			std::unordered_map<std::string_view, NodeHandle> mNameIndex;
+
+			std::vector<NodePose> mLocalPoses;
+			std::vector<NodePose> mInitialPoses;
+			std::vector<uint8_t> mInheritOrientation;
+			std::vector<uint8_t> mInheritScale;
+
+			std::vector<std::vector<AssimpMeshRef>> mMeshes;
+
+			/// Derived (model space) poses and transforms, valid for nodes below mFirstDirty.
+			mutable std::vector<NodePose> mDerivedPoses;
+			mutable std::vector<ci::mat4> mDerivedTransforms;
+			mutable std::vector<uint8_t> mDirty;
+			mutable size_t mFirstDirty;
+			uint64_t mVersion;
+		};
+	}
+}
@@ -0,0 +1,121 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "assimp/matrix4x4.h"
+
+#include "NodeHierarchy.h"
+
+namespace sitara {
+	namespace assimp {
+		class PoseCache;
+		typedef std::shared_ptr<PoseCache> PoseCacheRef;
+
+		//! Sampled animation poses shared between loaders of the same model, so instances playing
+		// a clip in lockstep (or at a few phase offsets) sample it once.  Entries are keyed on
+		// (model, clip, time quantized to getTimeQuantum()) and evicted least recently used first.
+		// Thread safe; loaders updated by an UpdateScheduler may share one cache.
+		class PoseCache
+		{
+			public:
+				struct Key {
+					size_t mModel;
+					size_t mAnimation;
+					int64_t mTimeStep;
+
+					bool operator==(const Key& other) const {
+						return mModel == other.mModel && mAnimation == other.mAnimation && mTimeStep == other.mTimeStep;
+					}
+				};
+
+				//! Local pose of every channel of the clip, and the skeleton palette they produce
+				// (empty if the model wasn't skinned when the entry was made).
+				struct Entry {
+					std::vector<NodePose> mChannelPoses;
+					std::vector<aiMatrix4x4> mPalette;
+				};
+				typedef std::shared_ptr<const Entry> EntryRef;
+
+				struct Stats {
+					uint64_t mHits = 0;
+					uint64_t mMisses = 0;
+					uint64_t mEvictions = 0;
+
+					double getHitRate() const {
+						return (mHits + mMisses) > 0 ? double(mHits) / double(mHits + mMisses) : 0.0;
+					}
+				};
+
+				//! Creates a cache quantizing time to \a timeQuantum seconds and holding up to
+				// \a capacity entries.
+				static PoseCacheRef create(double timeQuantum = 1.0 / 60.0, size_t capacity = 256);
+
+				//! Returns a small id for \a model, e.g. a file path; loaders of the same model
+				// share their entries through it.
+				size_t getModelId(const std::string& model);
+
+				//! Returns the key of \a time in \a animation of \a model.
+				Key getKey(size_t model, size_t animation, double time) const;
+				//! Returns the time the entries of \a key are sampled at.
+				double getSampleTime(const Key& key) const { return key.mTimeStep * mTimeQuantum; }
+
+				//! Returns the entry of \a key, or null, and counts a hit or a miss.
+				EntryRef find(const Key& key);
+				//! Stores \a entry under \a key, evicting the least recently used entry when full.
+				void insert(const Key& key, EntryRef entry);
+				void clear();
+
+				//! Changing the quantum clears the cache.
+				void setTimeQuantum(double seconds);
+				double getTimeQuantum() const { return mTimeQuantum; }
+				void setCapacity(size_t capacity);
+				size_t getCapacity() const { return mCapacity; }
+				size_t getSize() const;
+
+				Stats getStats() const;
+				void resetStats();
+
+			protected:
+				PoseCache(double timeQuantum, size_t capacity);
+
+				void evict();
+
+				struct KeyHash {
+					size_t operator()(const Key& key) const;
+				};
+				typedef std::list<std::pair<Key, EntryRef>> EntryList;
+
+				mutable std::mutex mMutex;
+				double mTimeQuantum;
+				size_t mCapacity;
+				/// most recently used first
+				EntryList mEntries;
+				std::unordered_map<Key, EntryList::iterator, KeyHash> mIndex;
+				std::unordered_map<std::string, size_t> mModelIds;
+				Stats mStats;
+		};
+	}
+}
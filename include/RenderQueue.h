@@ -0,0 +1,100 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Texture.h"
+
+#include "AssimpMesh.h"
+#include "NodeHierarchy.h"
+
+namespace sitara {
+	namespace assimp {
+		class RenderQueue;
+		typedef std::shared_ptr<RenderQueue> RenderQueueRef;
+
+		//! One mesh with the GL state it is drawn with.
+		struct RenderItem {
+			//! Program, texture, face culling and material packed so that sorting by key groups
+			// meshes sharing state; filled in by RenderQueue::push().
+			uint64_t mKey = 0;
+			AssimpMeshRef mMesh;
+			ci::gl::GlslProgRef mShader;
+			ci::gl::Texture2dRef mTexture;
+			bool mCullFace = false;
+			//! Whether the material uniforms of the mesh are set on mShader.
+			bool mMaterialUniforms = false;
+			//! Index of the mesh's material among the distinct materials of the queue.
+			uint32_t mMaterial = 0;
+			//! Part of the mesh to draw; with no indices the whole mesh, minus the hidden ranges
+			// of a merged mesh, is drawn.
+			uint32_t mFirstIndex = 0;
+			uint32_t mNumIndices = 0;
+			//! Node whose derived transform places the mesh; none for skinned meshes, whose
+			// vertices are in model space already.
+			NodeHandle mNode = InvalidNodeHandle;
+		};
+
+		//! Draw submissions sorted by GL state, so a frame switches programs, textures, culling
+		// and material uniforms as rarely as possible.  The queue is built once and only rebuilt
+		// when the state of a mesh changes.
+		class RenderQueue
+		{
+			public:
+				//! State changes made by the last submission.
+				struct Stats {
+					size_t mNumDraws = 0;
+					size_t mNumProgramChanges = 0;
+					size_t mNumTextureChanges = 0;
+					size_t mNumCullChanges = 0;
+					size_t mNumMaterialChanges = 0;
+
+					size_t getNumStateChanges() const {
+						return mNumProgramChanges + mNumTextureChanges + mNumCullChanges + mNumMaterialChanges;
+					}
+				};
+
+				static RenderQueueRef create();
+
+				void clear();
+				//! Adds \a item, assigning its material index and sort key.
+				void push(RenderItem item);
+				//! Orders the items by key; items with equal keys keep the order they were pushed in.
+				void sort();
+
+				const std::vector<RenderItem>& getItems() const { return mItems; }
+				//! Returns the distinct materials of the queue, indexed by RenderItem::mMaterial.
+				const std::vector<Material>& getMaterials() const { return mMaterials; }
+				bool empty() const { return mItems.empty(); }
+
+			protected:
+				RenderQueue() {}
+
+				uint32_t getId(std::vector<const void*>& ids, const void* object);
+				uint32_t getMaterialId(const Material& material);
+
+				std::vector<RenderItem> mItems;
+				std::vector<const void*> mPrograms;
+				std::vector<const void*> mTextures;
+				std::vector<Material> mMaterials;
+		};
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "assimp/mesh.h"
+
+namespace sitara {
+	namespace assimp {
+		//! Maximum number of bones influencing a single vertex.
+		const size_t MaxBoneInfluences = 4;
+
+		//! Bone influences of every vertex of a mesh, MaxBoneInfluences entries per vertex, sorted
+		// by decreasing weight.  Unused entries have a weight of 0.
+		struct BoneInfluences {
+			std::vector<uint32_t> mBones;
+			std::vector<float> mWeights;
+
+			bool empty() const { return mWeights.empty(); }
+			size_t getNumVertices() const { return mWeights.size() / MaxBoneInfluences; }
+		};
+
+		//! Converts the per-bone vertex weights of \a mesh into a per-vertex table, keeping the
+		// MaxBoneInfluences strongest bones of every vertex and renormalizing their weights.
+		BoneInfluences buildBoneInfluences(const aiMesh* mesh);
+
+		//! The vertices influenced by every bone of a mesh, in increasing order, stored back to
+		// back: the vertices of bone \a b are mVertices[mOffsets[b]] up to mVertices[mOffsets[b + 1]].
+		struct BoneVertexLists {
+			std::vector<uint32_t> mOffsets;
+			std::vector<uint32_t> mVertices;
+
+			bool empty() const { return mOffsets.empty(); }
+			size_t getNumVertices(size_t bone) const { return mOffsets[bone + 1] - mOffsets[bone]; }
+			const uint32_t* getVertices(size_t bone) const { return mVertices.data() + mOffsets[bone]; }
+		};
+
+		//! Inverts \a influences into per-bone vertex lists, so the vertices moved by a subset of
+		// the \a numBones bones can be found without visiting the whole mesh.
+		BoneVertexLists buildBoneVertexLists(const BoneInfluences& influences, size_t numBones);
+
+		//! Implementations of skinVertices().
+		enum class SkinningKernel {
+			Scalar,
+			//! Blends the bone matrices of one vertex with SSE2.
+			Sse,
+			//! Blends the bone matrices of two vertices at once, one in each 128 bit lane of AVX.
+			Avx
+		};
+
+		//! Returns whether \a kernel can run on this CPU.
+		bool isSkinningKernelSupported(SkinningKernel kernel);
+		//! Returns the kernel used by skinVertices(); by default the fastest one the CPU supports.
+		SkinningKernel getSkinningKernel();
+		//! Sets the process-wide kernel used by skinVertices() without a kernel argument.
+		// Unsupported kernels fall back to SkinningKernel::Scalar.  Affects every thread; to
+		// use another kernel for a single call or loader, pass it to skinVertices() or
+		// AssimpLoader::setSkinningKernel() instead.
+		void setSkinningKernel(SkinningKernel kernel);
+
+		//! Skins \a count vertices starting at \a first: every output vertex is the weighted sum of
+		// its source vertex transformed by its bones' matrices.  The destinations are tightly
+		// packed xyz floats, e.g. the positions and normals of a ci::TriMesh, so skinning can
+		// write straight into render storage.  \a srcNormals and \a dstNormals may be null.
+		// The SIMD kernels blend the bone matrices before transforming, so results differ from
+		// the scalar kernel only by float rounding.
+		void skinVertices(const BoneInfluences& influences, const aiMatrix4x4* boneMatrices,
+						  const aiVector3D* srcPositions, const aiVector3D* srcNormals,
+						  float* dstPositions, float* dstNormals,
+						  size_t first, size_t count);
+		//! Skins with \a kernel instead of getSkinningKernel(); an unsupported kernel falls back
+		// to SkinningKernel::Scalar.
+		void skinVertices(SkinningKernel kernel, const BoneInfluences& influences, const aiMatrix4x4* boneMatrices,
+						  const aiVector3D* srcPositions, const aiVector3D* srcNormals,
+						  float* dstPositions, float* dstNormals,
+						  size_t first, size_t count);
+	}
+}
@@ -0,0 +1,149 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Batch.h"
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Vbo.h"
+#include "cinder/gl/VboMesh.h"
+
+#include "AssimpMesh.h"
+#include "NodeHierarchy.h"
+
+namespace sitara {
+	namespace assimp {
+		class StaticArena;
+		typedef std::shared_ptr<StaticArena> StaticArenaRef;
+
+		//! The static meshes of a model packed into one shared vertex and index buffer, drawn
+		// with a handful of glMultiDrawElementsIndirect calls.  Every mesh is one indirect command
+		// whose base instance is its draw index; the vertex shader reads the mesh's node transform
+		// and material from storage buffers at that index (see glsl/vertex/arena.vert).  Without
+		// GL 4.3 the buffers are the same but every command is drawn on its own.
+		class StaticArena
+		{
+			public:
+				//! One mesh of the arena.
+				struct Draw {
+					AssimpMesh* mMesh = nullptr;
+					const AssimpMesh* mSource = nullptr; /// original mesh of a range of a merged mesh, otherwise mMesh
+					NodeHandle mNode = InvalidNodeHandle; /// node whose derived transform places the mesh, none for model space
+					uint32_t mMaterial = 0; /// index into getMaterials()
+					ci::gl::Texture2dRef mTexture;
+					bool mCullFace = false;
+					//! Indices of the draw in the arena; until build() the range within the mesh, with
+					// no indices meaning the whole mesh.
+					uint32_t mFirstIndex = 0;
+					uint32_t mNumIndices = 0;
+					int32_t mBaseVertex = 0;
+				};
+
+				//! Layout of a glMultiDrawElementsIndirect command.
+				struct DrawCommand {
+					uint32_t mCount;
+					uint32_t mInstanceCount;
+					uint32_t mFirstIndex;
+					int32_t mBaseVertex;
+					uint32_t mBaseInstance; /// index of the Draw
+				};
+
+				//! Consecutive commands sharing texture and face culling, drawn with one call.
+				struct Group {
+					ci::gl::Texture2dRef mTexture;
+					bool mCullFace = false;
+					size_t mFirstCommand = 0;
+					size_t mNumCommands = 0;
+				};
+
+				static StaticArenaRef create();
+
+				//! Returns whether the current context has multi-draw-indirect and storage buffers (GL 4.3).
+				static bool isMultiDrawIndirectSupported();
+
+				//! Adds \a mesh, placed by node \a node or untransformed with InvalidNodeHandle.  Meshes sharing the same aiMaterial share
+				// one material entry.  A mesh merged by static batching becomes one draw per range,
+				// so hidden ranges can be skipped.
+				void add(AssimpMesh* mesh, NodeHandle node);
+				//! Sorts the draws by face culling, texture and material and uploads the buffers;
+				// requires a GL context.  Uses glMultiDrawElementsIndirect if \a multiDrawIndirect is
+				// true and the context supports it.
+				void build(bool multiDrawIndirect = true);
+
+				//! Copies the derived transforms of the draws' nodes into the transform buffer.
+				void updateTransforms(const NodeHierarchy& hierarchy);
+				//! Writes the commands of the visible meshes, grouped by texture if \a textured is true.
+				void updateCommands(bool textured);
+				//! Binds the transform, material and draw material buffers to the storage buffer
+				// bindings 0 to 2 read by arena.vert and arena.frag.
+				void bindBuffers() const;
+				//! Returns the GL_DRAW_INDIRECT_BUFFER holding getCommands(), null without multi-draw-indirect.
+				ci::gl::VboRef getCommandBuffer() const { return mCommandBuffer; }
+
+				//! Returns a batch drawing the arena's vertices with \a shader, which may read the
+				// draw index from the attribute "iDrawId".
+				ci::gl::BatchRef getBatch(const ci::gl::GlslProgRef& shader);
+
+				bool isMultiDrawIndirect() const { return mMultiDrawIndirect; }
+				bool empty() const { return mDraws.empty(); }
+				size_t getNumDraws() const { return mDraws.size(); }
+				const Draw& getDraw(size_t i) const { return mDraws[i]; }
+				const ci::mat4& getTransform(size_t i) const { return mTransforms[i]; }
+				const std::vector<Material>& getMaterials() const { return mMaterials; }
+				const std::vector<DrawCommand>& getCommands() const { return mCommands; }
+				const std::vector<Group>& getGroups() const { return mGroups; }
+				size_t getNumVertices() const { return mNumVertices; }
+				size_t getNumIndices() const { return mNumIndices; }
+				//! Returns the size of the vertex and index buffers.
+				size_t getNumBytes() const;
+
+			protected:
+				StaticArena();
+
+				//! Interleaved vertex of the arena.
+				struct Vertex {
+					ci::vec3 mPosition;
+					ci::vec3 mNormal;
+					ci::vec2 mTexCoord;
+					ci::ColorAf mColor;
+				};
+
+				std::vector<Draw> mDraws;
+				std::vector<Material> mMaterials;
+				std::unordered_map<uint32_t, uint32_t> mMaterialIndices; /// arena material of every AssimpMesh::mMaterialIndex
+				std::vector<ci::mat4> mTransforms; /// per draw
+				std::vector<DrawCommand> mCommands;
+				std::vector<Group> mGroups;
+				size_t mNumVertices;
+				size_t mNumIndices;
+				bool mMultiDrawIndirect;
+
+				ci::gl::VboMeshRef mVboMesh;
+				ci::gl::VboRef mCommandBuffer;
+				ci::gl::SsboRef mTransformBuffer;
+				ci::gl::SsboRef mMaterialBuffer;
+				ci::gl::SsboRef mDrawMaterialBuffer; /// material index of every draw
+				std::unordered_map<ci::gl::GlslProgRef, ci::gl::BatchRef> mBatches; /// per shader drawn with
+		};
+	}
+}
@@ -0,0 +1,80 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/Vbo.h"
+
+namespace sitara {
+	namespace assimp {
+		class StreamingBuffer;
+		typedef std::shared_ptr<StreamingBuffer> StreamingBufferRef;
+
+		//! A vertex buffer rewritten every frame without stalling on draws still reading it.
+		// With glBufferStorage (GL 4.4) the buffer holds several regions, is mapped persistently
+		// and every frame writes the next region, waiting on a fence only if the GPU is still
+		// behind.  Otherwise it has a single region and every write orphans the old storage.
+		class StreamingBuffer
+		{
+			public:
+				//! Creates a buffer of \a numRegions regions of \a regionBytes bytes each; requires a
+				// GL context.
+				static StreamingBufferRef create(size_t regionBytes, size_t numRegions = 3);
+				~StreamingBuffer();
+
+				//! Returns the memory of the next region, valid until endWrite().
+				uint8_t* beginWrite();
+				//! Publishes the first \a bytes bytes written since beginWrite(); the region becomes
+				// the one returned by getRegion().
+				void endWrite(size_t bytes);
+
+				ci::gl::VboRef getVbo() const { return mVbo; }
+				//! Returns the region written last, which draws should read.
+				size_t getRegion() const { return mRegion; }
+				size_t getNumRegions() const { return mNumRegions; }
+				size_t getRegionBytes() const { return mRegionBytes; }
+				//! Returns the byte offset of region \a region in getVbo().
+				size_t getRegionOffset(size_t region) const { return region * mRegionBytes; }
+				//! Returns true if the buffer is persistently mapped, false if it falls back to orphaning.
+				bool isPersistent() const { return mPersistent; }
+
+				//! Returns the number of bytes written since creation.
+				uint64_t getUploadBytes() const { return mUploadBytes; }
+				//! Returns how often beginWrite() had to wait for the GPU.
+				uint64_t getNumStalls() const { return mNumStalls; }
+
+			protected:
+				StreamingBuffer(size_t regionBytes, size_t numRegions);
+
+				ci::gl::VboRef mVbo;
+				size_t mRegionBytes;
+				size_t mNumRegions;
+				size_t mRegion;
+				size_t mPendingRegion; /// region handed out by beginWrite()
+				bool mPersistent;
+				uint8_t* mMapped;
+				std::vector<GLsync> mFences; /// one per region, set when draws reading it were submitted
+				std::vector<uint8_t> mStaging; /// write target when orphaning
+				uint64_t mUploadBytes;
+				uint64_t mNumStalls;
+		};
+	}
+}
@@ -0,0 +1,79 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cinder/Area.h"
+#include "cinder/Rect.h"
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
+
+namespace sitara {
+	namespace assimp {
+		class TextureAtlas;
+		typedef std::shared_ptr<TextureAtlas> TextureAtlasRef;
+
+		//! Packs many small images into a few large textures, so meshes using different images
+		// can be drawn without rebinding.  Images are placed on shelves sorted by height and
+		// surrounded by a border of repeated edge pixels, which keeps filtering and the first
+		// mip levels from bleeding into neighbours.
+		class TextureAtlas
+		{
+			public:
+				//! Where an image ended up.
+				struct Tile {
+					size_t mPage = 0;
+					ci::Area mArea; /// pixels of the image in its page
+					ci::Rectf mTexCoords; /// texture coordinates of mArea, in the orientation of a ci::gl::Texture
+				};
+
+				//! Creates an atlas of pages of at most \a pageSize square pixels, leaving \a padding
+				// pixels around every image.
+				static TextureAtlasRef create(int pageSize = 2048, int padding = 4);
+
+				//! Adds \a surface under \a key.  Returns false if it can't fit into a page.
+				bool add(const std::string& key, const ci::Surface8u& surface);
+				//! Packs everything added and uploads the pages as mipmapped textures; requires a GL
+				// context.  Pages are cropped to the shelves they use.
+				void pack();
+
+				bool contains(const std::string& key) const { return mIndices.count(key) > 0; }
+				const Tile& getTile(const std::string& key) const { return mTiles[mIndices.at(key)]; }
+				size_t getNumImages() const { return mTiles.size(); }
+
+				size_t getNumPages() const { return mPages.size(); }
+				ci::gl::Texture2dRef getPage(size_t n) const { return mPages[n]; }
+				//! Returns the fraction of the pages' pixels covered by images.
+				float getOccupancy() const { return mOccupancy; }
+
+			protected:
+				TextureAtlas(int pageSize, int padding);
+
+				int mPageSize;
+				int mPadding;
+				std::unordered_map<std::string, size_t> mIndices; /// tile of every key
+				std::vector<ci::Surface8u> mSurfaces; /// images waiting for pack()
+				std::vector<Tile> mTiles;
+				std::vector<ci::gl::Texture2dRef> mPages;
+				float mOccupancy;
+		};
+	}
+}
@@ -0,0 +1,74 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sitara {
+	namespace assimp {
+		class ThreadPool;
+		typedef std::shared_ptr<ThreadPool> ThreadPoolRef;
+
+		//! Small work-stealing thread pool.  Every worker owns a task deque; idle workers steal
+		// from the front of the other deques.  Threads blocked in parallelFor() help execute
+		// pending tasks instead of sleeping, so parallelFor() may be nested safely.
+		class ThreadPool
+		{
+			public:
+				//! Creates a pool using \a numThreads threads, counting the calling thread.  Passing
+				// 0 uses std::thread::hardware_concurrency(); passing 1 runs everything serially.
+				static ThreadPoolRef create(size_t numThreads = 0);
+				~ThreadPool();
+
+				//! Returns the number of threads taking part in parallelFor(), including the caller.
+				size_t getNumThreads() const { return mQueues.size(); }
+
+				//! Calls \a task with every index in [0, \a count) and blocks until all calls returned.
+				// The first exception thrown by a task is rethrown on the calling thread.
+				void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+			private:
+				ThreadPool(size_t numThreads);
+
+				struct TaskQueue {
+					std::mutex mMutex;
+					std::deque<std::function<void()>> mTasks;
+				};
+
+				void push(size_t queueIndex, std::function<void()> task);
+				bool runPendingTask(size_t homeQueue);
+				void workerLoop(size_t queueIndex);
+				size_t getHomeQueue();
+
+				std::vector<std::unique_ptr<TaskQueue>> mQueues;
+				std::vector<std::thread> mThreads;
+
+				std::mutex mWakeMutex;
+				std::condition_variable mWakeCondition;
+				std::atomic<size_t> mNumQueued;
+				bool mStopping;
+		};
+	}
+}
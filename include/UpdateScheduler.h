@@ -0,0 +1,76 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "AssimpLoader.h"
+#include "ThreadPool.h"
+
+namespace sitara {
+	namespace assimp {
+		class UpdateScheduler;
+		typedef std::shared_ptr<UpdateScheduler> UpdateSchedulerRef;
+
+		//! Updates many AssimpLoaders at once.  The CPU stages of every loader (animation,
+		// skinning and mesh updates) run as independent jobs on a ThreadPool; anything touching
+		// GL stays on the thread calling update().
+		class UpdateScheduler
+		{
+			public:
+				//! Timing of the last call to update().
+				struct Stats {
+					size_t mNumThreads = 0;
+					size_t mNumLoaders = 0;
+					//! Wall-clock time of the whole batch.
+					double mWallSeconds = 0.0;
+					//! Sum of the time spent inside each loader's update.
+					double mBusySeconds = 0.0;
+					//! Time spent uploading vertices on the calling thread, included in mWallSeconds.
+					double mGpuSeconds = 0.0;
+					//! Vertex bytes uploaded by the GPU phase.
+					uint64_t mUploadBytes = 0;
+
+					//! Returns the parallel efficiency: 1.0 means every thread was busy for the whole batch.
+					double getEfficiency() const {
+						return (mWallSeconds > 0.0 && mNumThreads > 0) ? mBusySeconds / (mWallSeconds * mNumThreads) : 0.0;
+					}
+				};
+
+				//! Creates a scheduler with its own pool of \a numThreads threads (0 = one per core).
+				static UpdateSchedulerRef create(size_t numThreads = 0);
+				//! Creates a scheduler sharing an existing pool.
+				static UpdateSchedulerRef create(ThreadPoolRef pool);
+
+				//! Updates all \a loaders and blocks until every one of them is done, then uploads
+				// their changed vertices with AssimpLoader::updateGpu() on the calling thread, which
+				// has to own the GL context.
+				void update(const std::vector<AssimpLoaderRef>& loaders);
+
+				const Stats& getLastStats() const { return mLastStats; }
+				ThreadPoolRef getThreadPool() const { return mThreadPool; }
+
+			private:
+				UpdateScheduler(ThreadPoolRef pool);
+
+				ThreadPoolRef mThreadPool;
+				std::vector<double> mLoaderSeconds;
+				Stats mLastStats;
+		};
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cinder/Cinder.h"
+#include "cinder/Filesystem.h"
+#include "cinder/gl/Texture.h"
+
+#include "AssimpLoader.h"
+
+namespace sitara {
+	namespace assimp {
+		class VertexAnimation;
+		typedef std::shared_ptr<VertexAnimation> VertexAnimationRef;
+
+		//! An animation clip baked into per-frame vertex positions and normals, laid out as
+		// texture data so a vertex shader (glsl/vertex/vat.vert) can play it back without any
+		// CPU skinning.  Every frame occupies getRowsPerFrame() rows of getTextureWidth() RGBA
+		// texels; the vertices of all meshes are stored one after another, starting at
+		// getMeshOffset().
+		class VertexAnimation
+		{
+			public:
+				struct Format {
+					Format() : mSampleRate(30.0f), mHalfFloat(false), mNormals(true), mTextureWidth(4096), mScalarSkinning(true) {}
+
+					//! Frames baked per second of animation.
+					Format& sampleRate(float rate) { mSampleRate = rate; return *this; }
+					//! Stores 16 bit floats instead of 32 bit floats, halving the size.
+					Format& halfFloat(bool half = true) { mHalfFloat = half; return *this; }
+					//! Bakes normals next to positions.
+					Format& normals(bool normals = true) { mNormals = normals; return *this; }
+					//! Width of the textures in texels; must not exceed GL_MAX_TEXTURE_SIZE.
+					Format& textureWidth(int width) { mTextureWidth = width; return *this; }
+					//! Skins with SkinningKernel::Scalar while baking, so bakes are reproducible
+					// across CPUs; see AssimpLoader::setSkinningKernel().
+					Format& scalarSkinning(bool scalar = true) { mScalarSkinning = scalar; return *this; }
+
+					float mSampleRate;
+					bool mHalfFloat;
+					bool mNormals;
+					int mTextureWidth;
+					bool mScalarSkinning;
+				};
+
+				//! Bakes animation \a animation of \a loader by stepping it through the clip at
+				// the sample rate of \a format.  The loader's animation, time and skinning
+				// settings, including its skinning kernel, are restored afterwards; other
+				// loaders are unaffected.  Touches no GL state.  Vertices are baked in model
+				// space: meshes without bones are moved by the derived transform of their node
+				// (AssimpLoader::getMeshNode()), so node animation is baked too, and a mesh
+				// referenced by several nodes is baked at the first of them only.
+				static VertexAnimationRef bake(const AssimpLoaderRef& loader, size_t animation, const Format& format = Format());
+				//! Reads a bake written by save(); throws AssimpLoaderExc on malformed files.
+				static VertexAnimationRef load(const ci::fs::path& path);
+				//! Writes the bake as a compact binary file.
+				void save(const ci::fs::path& path) const;
+
+				//! Creates the position texture; requires a GL context.
+				ci::gl::Texture2dRef createPositionTexture() const;
+				//! Creates the normal texture, or returns null if normals weren't baked.  vat.vert
+				// only samples it when uVatHasNormals is set to hasNormals(), and keeps the
+				// unanimated ciNormal otherwise.
+				ci::gl::Texture2dRef createNormalTexture() const;
+
+				size_t getNumFrames() const { return mNumFrames; }
+				size_t getNumVertices() const { return mMeshOffsets.empty() ? 0 : mMeshOffsets.back(); }
+				size_t getNumMeshes() const { return mMeshOffsets.empty() ? 0 : mMeshOffsets.size() - 1; }
+				//! Returns the index of the first vertex of the \a n'th mesh, the uVertexOffset of vat.vert.
+				size_t getMeshOffset(size_t n) const { return mMeshOffsets[n]; }
+				//! Returns the frames per second of the bake: the rate of the Format, rounded so
+				// the frames evenly span the clip and the last one is its end.
+				float getSampleRate() const { return mSampleRate; }
+				bool isHalfFloat() const { return mHalfFloat; }
+				bool hasNormals() const { return !mNormals.empty() || !mHalfNormals.empty(); }
+				int getTextureWidth() const { return mTextureWidth; }
+				int getRowsPerFrame() const { return mRowsPerFrame; }
+				int getTextureHeight() const { return mRowsPerFrame * static_cast<int>(mNumFrames); }
+
+				//! Returns the baked position of \a vertex in \a frame, as the shader reads it.
+				ci::vec3 getPosition(size_t frame, size_t vertex) const;
+				//! Returns the baked normal of \a vertex in \a frame, as the shader reads it.
+				ci::vec3 getNormal(size_t frame, size_t vertex) const;
+
+				//! Returns the size of the baked data in bytes.
+				size_t getNumBytes() const;
+				//! Returns the largest difference between a skinned position and its stored value;
+				// 0 unless positions were stored as half floats.
+				float getMaxPositionError() const { return mMaxPositionError; }
+				//! Returns the largest difference between a skinned normal and its stored value.
+				float getMaxNormalError() const { return mMaxNormalError; }
+
+			protected:
+				VertexAnimation();
+
+				void allocate();
+				size_t getTexelIndex(size_t frame, size_t vertex) const;
+				void store(std::vector<float>& data, std::vector<uint16_t>& halfData, size_t texel, const ci::vec3& v, float* maxError);
+				ci::vec3 fetch(const std::vector<float>& data, const std::vector<uint16_t>& halfData, size_t texel) const;
+				ci::gl::Texture2dRef createTexture(const std::vector<float>& data, const std::vector<uint16_t>& halfData) const;
+
+				size_t mNumFrames;
+				std::vector<uint32_t> mMeshOffsets; /// first vertex of every mesh, followed by the vertex count
+				float mSampleRate;
+				bool mHalfFloat;
+				int mTextureWidth;
+				int mRowsPerFrame;
+
+				/// RGBA texels, one set of arrays is used depending on mHalfFloat
+				std::vector<float> mPositions;
+				std::vector<float> mNormals;
+				std::vector<uint16_t> mHalfPositions;
+				std::vector<uint16_t> mHalfNormals;
+
+				float mMaxPositionError;
+				float mMaxNormalError;
+		};
+	}
+}
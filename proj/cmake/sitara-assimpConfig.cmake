@@ -0,0 +1,23 @@
+if( NOT TARGET sitara-assimp )
+	get_filename_component( SITARA_ASSIMP_PATH "${CMAKE_CURRENT_LIST_DIR}/../.." ABSOLUTE )
+
+	file( GLOB SITARA_ASSIMP_SOURCES "${SITARA_ASSIMP_PATH}/src/*.cpp" )
+	add_library( sitara-assimp ${SITARA_ASSIMP_SOURCES} )
+	target_compile_features( sitara-assimp PUBLIC cxx_std_17 )
+	target_compile_definitions( sitara-assimp PUBLIC SITARA_ASSIMP_PATH="${SITARA_ASSIMP_PATH}" )
+
+	target_include_directories( sitara-assimp PUBLIC "${SITARA_ASSIMP_PATH}/include" )
+	target_include_directories( sitara-assimp SYSTEM BEFORE PUBLIC "${CINDER_PATH}/include" )
+
+	find_package( assimp REQUIRED )
+	find_package( Threads REQUIRED )
+	target_link_libraries( sitara-assimp PUBLIC assimp::assimp Threads::Threads )
+
+	if( NOT TARGET cinder )
+		include( "${CINDER_PATH}/proj/cmake/configure.cmake" )
+		find_package( cinder REQUIRED PATHS
+			"${CINDER_PATH}/${CINDER_LIB_DIRECTORY}"
+			"$ENV{CINDER_PATH}/${CINDER_LIB_DIRECTORY}" )
+	endif()
+	target_link_libraries( sitara-assimp PRIVATE cinder )
+endif()
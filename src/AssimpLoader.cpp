@@ -18,7 +18,13 @@
  and Arturo Castro
 */
 
+#include <algorithm>
 #include <assert.h>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "cinder/app/App.h"
 #include "cinder/ImageIo.h"
@@ -32,7 +38,17 @@ using namespace std;
 using namespace ci;
 using namespace sitara::assimp;
 
-static TriMeshRef fromAssimp( const aiMesh *aim) {
+//! Number of vertices skinned by a single job.
+static const size_t SkinningChunkSize = 4096;
+//! Materials fitting into the smallest uniform block GL guarantees (16kB); MAX_MATERIALS in
+// blinn-phong-ubo.frag.
+static const size_t MaxUniformMaterials = 192;
+//! Uniform buffer binding of the material buffer.
+static const GLuint MaterialBufferBinding = 0;
+//! mAppliedPoseVersion before an animation was written to the nodes.
+static const uint64_t NotApplied = std::numeric_limits< uint64_t >::max();
+
+TriMeshRef sitara::assimp::fromAssimp( const aiMesh *aim) {
     ci::TriMesh::Format format;
     format.mPositionsDims = 3;
 	format.mNormalsDims = 3;
@@ -91,6 +107,179 @@ static TriMeshRef fromAssimp( const aiMesh *aim) {
 	return cim;
 }
 
+//! Bounds of the bind pose vertices influenced by every bone, in the space of the bone.
+static void calculateBoneBounds( AssimpMesh *assimpMesh )
+{
+	const aiMesh *mesh = assimpMesh->mAiMesh;
+	const BoneInfluences &influences = assimpMesh->mBoneInfluences;
+
+	vector< vec3 > mins( mesh->mNumBones, vec3( std::numeric_limits< float >::max() ) );
+	vector< vec3 > maxs( mesh->mNumBones, vec3( -std::numeric_limits< float >::max() ) );
+	for ( size_t v = 0; v < influences.getNumVertices(); ++v )
+	{
+		for ( size_t i = 0; i < MaxBoneInfluences && influences.mWeights[ v * MaxBoneInfluences + i ] > 0.0f; ++i )
+		{
+			uint32_t bone = influences.mBones[ v * MaxBoneInfluences + i ];
+			vec3 p = fromAssimp( mesh->mBones[ bone ]->mOffsetMatrix * mesh->mVertices[ v ] );
+			mins[ bone ] = glm::min( mins[ bone ], p );
+			maxs[ bone ] = glm::max( maxs[ bone ], p );
+		}
+	}
+
+	for ( unsigned a = 0; a < mesh->mNumBones; ++a )
+	{
+		if ( mins[ a ].x > maxs[ a ].x )
+			continue;
+		assimpMesh->mBoundedBones.push_back( a );
+		assimpMesh->mBoneBounds.push_back( AxisAlignedBox( mins[ a ], maxs[ a ] ) );
+	}
+}
+
+//! Includes \a box transformed by \a m in the box \a min - \a max; the transformed extents are
+// the absolute values of the matrix applied to the original extents (Arvo).
+static void includeTransformedBox( const aiMatrix4x4 &m, const AxisAlignedBox &box, vec3 *min, vec3 *max )
+{
+	const vec3 &c = box.getCenter();
+	const vec3 &e = box.getExtents();
+	const vec3 center( m.a1 * c.x + m.a2 * c.y + m.a3 * c.z + m.a4,
+					   m.b1 * c.x + m.b2 * c.y + m.b3 * c.z + m.b4,
+					   m.c1 * c.x + m.c2 * c.y + m.c3 * c.z + m.c4 );
+	const vec3 extents( std::abs( m.a1 ) * e.x + std::abs( m.a2 ) * e.y + std::abs( m.a3 ) * e.z,
+						std::abs( m.b1 ) * e.x + std::abs( m.b2 ) * e.y + std::abs( m.b3 ) * e.z,
+						std::abs( m.c1 ) * e.x + std::abs( m.c2 ) * e.y + std::abs( m.c3 ) * e.z );
+	*min = glm::min( *min, center - extents );
+	*max = glm::max( *max, center + extents );
+}
+
+//! Writes the positions and normals of \a assimpMesh into the next region of its vertex stream.
+static size_t streamVertices( AssimpMesh *assimpMesh )
+{
+	const std::vector< float > &positions = assimpMesh->mCachedTriMesh->getBufferPositions();
+	const std::vector< float > &normals = assimpMesh->mCachedTriMesh->getBufferNormals();
+	const size_t positionBytes = positions.size() * sizeof( float );
+	const size_t normalBytes = normals.size() * sizeof( float );
+
+	uint8_t *region = assimpMesh->mVertexStream->beginWrite();
+	memcpy( region, positions.data(), positionBytes );
+	if ( normalBytes > 0 )
+		memcpy( region + positionBytes, normals.data(), normalBytes );
+	assimpMesh->mVertexStream->endWrite( positionBytes + normalBytes );
+	return positionBytes + normalBytes;
+}
+
+//! Uploads the cached TriMesh of \a assimpMesh on its first draw.  Skinned and morphed meshes
+// stream their positions and normals through a ring buffer with one VboMesh per region; other
+// meshes keep them in buffers of their own, which are only rewritten when skinning is toggled.
+static void createVboMesh( AssimpMesh *assimpMesh )
+{
+	TriMeshRef triMesh = assimpMesh->mCachedTriMesh;
+	std::vector< std::pair< geom::BufferLayout, gl::VboRef > > staticBuffers;
+
+	auto addBuffer = [&]( geom::Attrib attrib, uint8_t dims, const std::vector< float > &data, GLenum usage ) -> gl::VboRef {
+		if ( data.empty() )
+			return nullptr;
+		geom::BufferLayout layout;
+		layout.append( attrib, dims, 0, 0 );
+		gl::VboRef vbo = gl::Vbo::create( GL_ARRAY_BUFFER, data, usage );
+		staticBuffers.push_back( std::make_pair( layout, vbo ) );
+		return vbo;
+	};
+
+	addBuffer( geom::Attrib::TEX_COORD_0, 2, triMesh->getBufferTexCoords0(), GL_STATIC_DRAW );
+	addBuffer( geom::Attrib::COLOR, 4, triMesh->getBufferColors(), GL_STATIC_DRAW );
+	gl::VboRef indexVbo = gl::Vbo::create( GL_ELEMENT_ARRAY_BUFFER, triMesh->getIndices(), GL_STATIC_DRAW );
+	const uint32_t numVertices = static_cast< uint32_t >( triMesh->getNumVertices() );
+	const uint32_t numIndices = static_cast< uint32_t >( triMesh->getNumIndices() );
+
+	const bool dynamic = assimpMesh->mAiMesh->HasBones() || !assimpMesh->mMorphTargets.empty();
+	if ( dynamic )
+	{
+		const size_t positionBytes = triMesh->getBufferPositions().size() * sizeof( float );
+		const size_t normalBytes = triMesh->getBufferNormals().size() * sizeof( float );
+		assimpMesh->mVertexStream = StreamingBuffer::create( positionBytes + normalBytes );
+
+		for ( size_t r = 0; r < assimpMesh->mVertexStream->getNumRegions(); ++r )
+		{
+			const size_t offset = assimpMesh->mVertexStream->getRegionOffset( r );
+			geom::BufferLayout layout;
+			layout.append( geom::Attrib::POSITION, 3, 0, offset );
+			if ( normalBytes > 0 )
+				layout.append( geom::Attrib::NORMAL, 3, 0, offset + positionBytes );
+
+			auto buffers = staticBuffers;
+			buffers.push_back( std::make_pair( layout, assimpMesh->mVertexStream->getVbo() ) );
+			assimpMesh->mStreamVboMeshes.push_back( gl::VboMesh::create( numVertices, GL_TRIANGLES, buffers, numIndices, GL_UNSIGNED_INT, indexVbo ) );
+		}
+		streamVertices( assimpMesh );
+	}
+	else
+	{
+		assimpMesh->mPositionVbo = addBuffer( geom::Attrib::POSITION, 3, triMesh->getBufferPositions(), GL_DYNAMIC_DRAW );
+		assimpMesh->mNormalVbo = addBuffer( geom::Attrib::NORMAL, 3, triMesh->getBufferNormals(), GL_DYNAMIC_DRAW );
+		assimpMesh->mVboMesh = gl::VboMesh::create( numVertices, GL_TRIANGLES, staticBuffers, numIndices, GL_UNSIGNED_INT, indexVbo );
+	}
+	assimpMesh->mGpuDirty = false;
+}
+
+//! Appends the transform of \a nd and of every node below it relative to the root, in the
+// order loadNodes() adds them to the hierarchy.
+static void collectNodeTransforms( const aiNode *nd, const aiMatrix4x4 &transform, vector< aiMatrix4x4 > *transforms )
+{
+	transforms->push_back( transform );
+	for ( unsigned n = 0; n < nd->mNumChildren; ++n )
+		collectNodeTransforms( nd->mChildren[ n ], transform * nd->mChildren[ n ]->mTransformation, transforms );
+}
+
+//! Returns \a materials in the std140 layout of blinn-phong-ubo.frag's Material, padded to the
+// size of the material buffer.
+static vector< vec4 > packMaterials( const vector< Material > &materials )
+{
+	vector< vec4 > packed;
+	packed.reserve( MaxUniformMaterials * 5 );
+	for ( const Material &material : materials )
+	{
+		packed.push_back( vec4( material.mDiffuse.r, material.mDiffuse.g, material.mDiffuse.b, material.mDiffuse.a ) );
+		packed.push_back( vec4( material.mSpecular.r, material.mSpecular.g, material.mSpecular.b, material.mSpecular.a ) );
+		packed.push_back( vec4( material.mAmbient.r, material.mAmbient.g, material.mAmbient.b, material.mAmbient.a ) );
+		packed.push_back( vec4( material.mEmission.r, material.mEmission.g, material.mEmission.b, material.mEmission.a ) );
+		packed.push_back( vec4( material.mShininess, 0, 0, 0 ) );
+	}
+	packed.resize( MaxUniformMaterials * 5, vec4( 0 ) );
+	return packed;
+}
+
+//! Returns the node placing \a assimpMesh of \a node when drawn; skinned vertices are in model
+// space already, as in the original drawMesh().
+static NodeHandle getPlacingNode( const AssimpNode &node, const AssimpMesh *assimpMesh )
+{
+	return assimpMesh->mAiMesh->HasBones() ? InvalidNodeHandle : static_cast< NodeHandle >( node.getIndex() );
+}
+
+//! Draws \a count indices of \a batch starting at \a first, \a numInstances times if not 0.
+static void drawBatchRange( const gl::BatchRef &batch, GLint first, GLsizei count, GLsizei numInstances )
+{
+	if ( numInstances == 0 )
+	{
+		batch->draw( first, count );
+		return;
+	}
+
+	gl::ScopedVao scopedVao( batch->getVao() );
+	gl::ScopedGlslProg scopedShader( batch->getGlslProg() );
+	gl::setDefaultShaderVars();
+	glDrawElementsInstanced( GL_TRIANGLES, count, GL_UNSIGNED_INT, reinterpret_cast< const void* >( first * sizeof( uint32_t ) ), numInstances );
+}
+
+static size_t countNodes( const aiNode *nd )
+{
+	size_t count = 1;
+	for ( unsigned n = 0; n < nd->mNumChildren; ++n )
+	{
+		count += countNodes( nd->mChildren[ n ] );
+	}
+	return count;
+}
+
 std::shared_ptr<AssimpLoader> sitara::assimp::AssimpLoader::create() {
     return std::shared_ptr<AssimpLoader>(new AssimpLoader());
 }
@@ -125,15 +314,81 @@ void sitara::assimp::AssimpLoader::preloadModel() {
 }
 
 void sitara::assimp::AssimpLoader::postloadModel() {
+    resetModel();
+    calculateDimensions();
+
+    loadAllMeshes();
+    mHierarchy = NodeHierarchy::create();
+    mAppliedPoseVersion = NotApplied;
+    mHierarchy->reserve(countNodes(mScene->mRootNode));
+    mRootNode = loadNodes(mScene->mRootNode);
+    resolveAnimationChannels();
+    resolveSkeleton();
+    if (mStaticBatchingEnabled) {
+        batchStaticMeshes();
+    }
+    updateAnimatedBounds();
+    if (!mGpuResourcesEnabled) {
+        return;
+    }
+    if (mTexturePackingEnabled) {
+        packTextures();
+    }
+    createMaterialBuffer();
+    createShaders();
+}
+
+void AssimpLoader::createShaders()
+{
+    // the phong shaders read the material buffer if all materials fit into it
     auto vertexShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/vertex/passthrough.vert"));
-    auto fragmentShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/frag/blinn-phong.frag"));
+    auto fragmentShader = ci::app::loadAsset(ci::app::getAssetPath(mMaterialUbo ? "glsl/frag/blinn-phong-ubo.frag" : "glsl/frag/blinn-phong.frag"));
 
     mPhongShaderProgram = ci::gl::GlslProg::create(vertexShader, fragmentShader);
 
-    calculateDimensions();
+    auto instancedShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/vertex/instanced.vert"));
+    auto instancedTintShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/vertex/instanced-tint.vert"));
+    auto lambertShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/frag/lambert.frag"));
+    mInstancedShaderProgram = ci::gl::GlslProg::create(instancedShader, lambertShader);
+    mInstancedPhongShaderProgram = ci::gl::GlslProg::create(instancedShader, fragmentShader);
+    mInstancedTintShaderProgram = ci::gl::GlslProg::create(instancedTintShader, lambertShader);
+    mInstancedTintPhongShaderProgram = ci::gl::GlslProg::create(instancedTintShader, fragmentShader);
+    auto lambertTextureShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/frag/lambert-texture.frag"));
+    mInstancedTextureShaderProgram = ci::gl::GlslProg::create(instancedShader, lambertTextureShader);
+    mInstancedTintTextureShaderProgram = ci::gl::GlslProg::create(instancedTintShader, lambertTextureShader);
+
+    if (mMaterialUbo) {
+        mPhongShaderProgram->uniformBlock("Materials", MaterialBufferBinding);
+        mInstancedPhongShaderProgram->uniformBlock("Materials", MaterialBufferBinding);
+        mInstancedTintPhongShaderProgram->uniformBlock("Materials", MaterialBufferBinding);
+    }
+    mMaterialsDirty = false;
+}
 
-    loadAllMeshes();
-    mRootNode = loadNodes(mScene->mRootNode);
+void AssimpLoader::resetModel()
+{
+	// a loader may load another model; nothing of the previous one may survive into the new one
+	mModelMeshes.clear();
+	mMeshNodes.clear();
+	mNodes.clear();
+	mRootNode.reset();
+	mAnimationNames.clear();
+	mAnimationChannelNodes.clear();
+	mAnimationMorphMeshes.clear();
+	mChannelPoses.clear();
+	mSkeletonNodes.clear();
+	mSkeletonPalette.clear();
+	mSkeletonVersions.clear();
+	mBatchedMeshes.clear();
+	mBatchedAiMeshes.clear();
+	mStaticArena.reset();
+	mTextureAtlas.reset();
+	mCustomPose = false;
+	mPoseCacheEntry.reset();
+	mMaterials.clear();
+	mMaterialIndices.clear();
+	mMaterialUbo.reset();
+	invalidateRenderQueue();
 }
 
 void AssimpLoader::calculateDimensions()
@@ -188,14 +443,12 @@ void AssimpLoader::calculateBoundingBoxForNode( const aiNode *nd, aiVector3D *mi
 	*trafo = prev;
 }
 
-AssimpNodeRef AssimpLoader::loadNodes( const aiNode *nd, AssimpNodeRef parentRef )
+AssimpNodeRef AssimpLoader::loadNodes( const aiNode *nd, int parentIndex )
 {
-	AssimpNodeRef nodeRef = AssimpNodeRef( new AssimpNode() );
-	nodeRef->setParent( parentRef );
 	string nodeName = fromAssimp( nd->mName );
-	nodeRef->setName( nodeName );
-	mNodeMap[ nodeName] = nodeRef;
-	mNodeNames.push_back( nodeName );
+	size_t nodeIndex = mHierarchy->addNode( nodeName, parentIndex );
+	AssimpNodeRef nodeRef = AssimpNodeRef( new AssimpNode( mHierarchy, nodeIndex ) );
+	mNodes.push_back( nodeRef );
 
 	// store transform
 	aiVector3D scaling;
@@ -215,6 +468,8 @@ AssimpNodeRef AssimpLoader::loadNodes( const aiNode *nd, AssimpNodeRef parentRef
 					toString< unsigned >( meshId ) + " from " +
 					toString< size_t >( mModelMeshes.size() ) + " meshes." );
 		nodeRef->getMeshes().push_back( mModelMeshes[ meshId ] );
+		if ( mModelMeshes[ meshId ]->mNode == InvalidNodeHandle )
+			mModelMeshes[ meshId ]->mNode = static_cast< NodeHandle >( nodeIndex );
 	}
 
 	// store the node with meshes for rendering
@@ -223,11 +478,11 @@ AssimpNodeRef AssimpLoader::loadNodes( const aiNode *nd, AssimpNodeRef parentRef
 		mMeshNodes.push_back( nodeRef );
 	}
 
-	// process all children
+	// process all children; the pre-order traversal keeps parents ahead of their children
+	// in the hierarchy arrays
 	for ( unsigned n = 0; n < nd->mNumChildren; ++n )
 	{
-		AssimpNodeRef childRef = loadNodes( nd->mChildren[ n ], nodeRef );
-		nodeRef->addChild( childRef );
+		loadNodes( nd->mChildren[ n ], static_cast< int >( nodeIndex ) );
 	}
 	return nodeRef;
 }
@@ -283,6 +538,8 @@ AssimpMeshRef AssimpLoader::convertAiMesh(const aiMesh* mesh) {
         assimpMeshRef->mMaterial.mShininess = shininess;
         CI_LOG_D("\tSpecular Highlights (Shininess): " << shininess);
     }
+
+    assignMaterialIndex(assimpMeshRef.get(), mesh->mMaterialIndex);
     /*
         // FIXME: not sensible data, obj .mtl Ns 96.078431 -> 384.314
         float shininessStrength = 1;
@@ -316,7 +573,7 @@ AssimpMeshRef AssimpLoader::convertAiMesh(const aiMesh* mesh) {
     aiString texPath;
 
     // TODO: handle other aiTextureTypes
-    if (AI_SUCCESS == mtl->GetTexture(aiTextureType_DIFFUSE, texIndex, &texPath)) {
+    if (mGpuResourcesEnabled && AI_SUCCESS == mtl->GetTexture(aiTextureType_DIFFUSE, texIndex, &texPath)) {
         fs::path texFsPath(texPath.data);
         fs::path modelFolder = mFilePath.parent_path();
         fs::path relTexPath = texFsPath.parent_path();
@@ -380,12 +637,14 @@ AssimpMeshRef AssimpLoader::convertAiMesh(const aiMesh* mesh) {
 
         if (std::filesystem::exists(realPath)) {
             assimpMeshRef->mTexture = gl::Texture::create(loadImage(realPath), format);
+            assimpMeshRef->mTexturePath = realPath;
         } else {
             CI_LOG_V("Could not find texture at " << realPath << "; trying to find texture locally.");
             // if the hard-coded model path doesn't work, see if we can find the texture file in the same directory
 			// check if it is in assets:
             if (std::filesystem::exists(localPath)) {
                 assimpMeshRef->mTexture = gl::Texture::create(loadImage(ci::app::getAssetPath(localPath)), format);
+                assimpMeshRef->mTexturePath = ci::app::getAssetPath(localPath);
             } else {
                 // if it isn't in the same directory or the hard-coded path, give up
                 CI_LOG_W("Could not find texture " << localPath.filename() << "; will load model without textures.");
@@ -394,14 +653,28 @@ AssimpMeshRef AssimpLoader::convertAiMesh(const aiMesh* mesh) {
     }
 
 	assimpMeshRef->mAiMesh = mesh;
+    assimpMeshRef->mBoneInfluences = buildBoneInfluences(mesh);
     assimpMeshRef->mCachedTriMesh = fromAssimp(mesh);
 	assimpMeshRef->mValidCache = true;
-    assimpMeshRef->mAnimatedPos.resize(mesh->mNumVertices);
-	if ( mesh->HasNormals() )
+
+	assimpMeshRef->mBindBounds = assimpMeshRef->mCachedTriMesh->calcBoundingBox();
+	assimpMeshRef->mAnimatedBounds = assimpMeshRef->mBindBounds;
+	calculateBoneBounds( assimpMeshRef.get() );
+
+	// morph targets are kept as sparse deltas and blended into a copy of the mesh before skinning
+	for ( unsigned t = 0; t < mesh->mNumAnimMeshes; ++t )
 	{
-		assimpMeshRef->mAnimatedNorm.resize( mesh->mNumVertices );
+		assimpMeshRef->mMorphTargets.push_back( buildMorphTarget( mesh, mesh->mAnimMeshes[ t ] ) );
+		assimpMeshRef->mMorphWeights.push_back( mesh->mAnimMeshes[ t ]->mWeight );
+	}
+	if ( mesh->mNumAnimMeshes > 0 )
+	{
+		assimpMeshRef->mMorphedPositions.resize( mesh->mNumVertices * 3 + 1 );
+		if ( mesh->HasNormals() )
+			assimpMeshRef->mMorphedNormals.resize( mesh->mNumVertices * 3 + 1 );
+		assimpMeshRef->mMorphDirty = true;
+		assimpMeshRef->mValidCache = false;
 	}
-
 
 	assimpMeshRef->mIndices.resize( mesh->mNumFaces * 3 );
 	unsigned j = 0;
@@ -413,62 +686,354 @@ AssimpMeshRef AssimpLoader::convertAiMesh(const aiMesh* mesh) {
 		}
 	}
 
+	// the vertex buffers are created by the first uploadMesh(), so loading needs no GL context
 	return assimpMeshRef;
 }
 
-void AssimpLoader::drawMesh(AssimpMeshRef mesh) {
-    if (mesh->mShowMesh) {
-        ci::gl::ShaderDef shaderDef = ci::gl::ShaderDef().lambert().color();
+void AssimpLoader::packTextures() {
+    std::vector<AssimpMeshRef> meshes = mModelMeshes;
+    meshes.insert(meshes.end(), mBatchedMeshes.begin(), mBatchedMeshes.end());
 
-        if (mesh->mTwoSided) {
-            gl::enable(GL_CULL_FACE);
-        } else {
-            gl::disable(GL_CULL_FACE);
-		}
+    // meshes sharing an image share a tile; only images whose meshes stay within [0, 1] can
+    // move into an atlas, repeating textures keep their own
+    std::map<std::string, std::vector<AssimpMesh*>> imageMeshes;
+    for (const AssimpMeshRef& assimpMeshRef : meshes) {
+        if (assimpMeshRef->mTexture && !assimpMeshRef->mTexturePath.empty()) {
+            imageMeshes[assimpMeshRef->mTexturePath.string()].push_back(assimpMeshRef.get());
+        }
+    }
 
-        if (mTexturesEnabled && mesh->mTexture) {
-            shaderDef.texture();
-            mesh->mTexture->bind();
+    const float epsilon = 1e-4f;
+    mTextureAtlas = TextureAtlas::create(mAtlasSize);
+    for (auto& image : imageMeshes) {
+        bool inside = true;
+        for (AssimpMesh* assimpMesh : image.second) {
+            const TriMesh& triMesh = *assimpMesh->mCachedTriMesh;
+            const vec2* texCoords = triMesh.hasTexCoords0() ? triMesh.getTexCoords0<2>() : nullptr;
+            for (size_t v = 0; texCoords && inside && v < triMesh.getNumVertices(); ++v) {
+                inside = glm::all(glm::greaterThanEqual(texCoords[v], vec2(-epsilon))) &&
+                         glm::all(glm::lessThanEqual(texCoords[v], vec2(1.0f + epsilon)));
+            }
+        }
+        if (!inside) {
+            CI_LOG_D("Not packing " << image.first << "; texture coordinates repeat");
+            continue;
+        }
+        if (!mTextureAtlas->add(image.first, Surface8u(loadImage(image.first)))) {
+            CI_LOG_D("Not packing " << image.first << "; too large for the atlas");
         }
+    }
+    mTextureAtlas->pack();
+
+    std::unordered_set<const gl::Texture2d*> pagesUsed;
+    mTexturePackingStats = TexturePackingStats();
+    for (auto& image : imageMeshes) {
+        if (!mTextureAtlas->contains(image.first))
+            continue;
+
+        const TextureAtlas::Tile& tile = mTextureAtlas->getTile(image.first);
+        for (AssimpMesh* assimpMesh : image.second) {
+            // map the texture coordinates into the tile; nothing was uploaded yet
+            assimpMesh->mTexture = mTextureAtlas->getPage(tile.mPage);
+            assimpMesh->mAtlasRect = tile.mTexCoords;
+            TriMesh& triMesh = *assimpMesh->mCachedTriMesh;
+            vec2* texCoords = triMesh.hasTexCoords0() ? triMesh.getTexCoords0<2>() : nullptr;
+            for (size_t v = 0; texCoords && v < triMesh.getNumVertices(); ++v) {
+                texCoords[v] = tile.mTexCoords.getUpperLeft() + texCoords[v] * tile.mTexCoords.getSize();
+            }
 
+            ++mTexturePackingStats.mNumBindsBefore;
+            pagesUsed.insert(assimpMesh->mTexture.get());
+        }
+    }
+    mTexturePackingStats.mNumImages = imageMeshes.size();
+    mTexturePackingStats.mNumPackedImages = mTextureAtlas->getNumImages();
+    mTexturePackingStats.mNumPages = mTextureAtlas->getNumPages();
+    mTexturePackingStats.mOccupancy = mTextureAtlas->getOccupancy();
+    mTexturePackingStats.mNumBindsAfter = pagesUsed.size();
+    CI_LOG_I("Packed " << mTexturePackingStats.mNumPackedImages << " of " << mTexturePackingStats.mNumImages
+             << " textures into " << mTexturePackingStats.mNumPages << " atlas pages, "
+             << static_cast<int>(mTexturePackingStats.mOccupancy * 100) << "% occupied; texture binds per frame "
+             << mTexturePackingStats.mNumBindsBefore << " -> " << mTexturePackingStats.mNumBindsAfter);
+}
+
+void AssimpLoader::assignMaterialIndex(AssimpMesh* assimpMesh, unsigned aiMaterialIndex) {
+    // meshes sharing an aiMaterial share one entry of the material buffer, unless one of them was
+    // edited; it then shares the entry of meshes edited alike, or gets one of its own
+    auto materialIt = mMaterialIndices.find(aiMaterialIndex);
+    if (materialIt != mMaterialIndices.end() && mMaterials[materialIt->second].isSameShading(assimpMesh->mMaterial)) {
+        assimpMesh->mMaterialIndex = materialIt->second;
+        return;
+    }
+    auto sameIt = std::find_if(mMaterials.begin(), mMaterials.end(),
+                               [assimpMesh](const Material& material) { return material.isSameShading(assimpMesh->mMaterial); });
+    if (sameIt == mMaterials.end()) {
+        sameIt = mMaterials.insert(mMaterials.end(), assimpMesh->mMaterial);
+    }
+    assimpMesh->mMaterialIndex = static_cast<uint32_t>(sameIt - mMaterials.begin());
+    if (materialIt == mMaterialIndices.end()) {
+        mMaterialIndices.emplace(aiMaterialIndex, assimpMesh->mMaterialIndex);
+    }
+}
+
+void AssimpLoader::createMaterialBuffer() {
+    if (mMaterials.size() > MaxUniformMaterials) {
+        CI_LOG_I("Model has " << mMaterials.size() << " materials, more than the material buffer holds; "
+                 << "setting material uniforms per mesh.");
+        return;
+    }
+
+    const std::vector<vec4> materials = packMaterials(mMaterials);
+    mMaterialUbo = gl::Ubo::create(materials.size() * sizeof(vec4), materials.data(), GL_DYNAMIC_DRAW);
+}
+
+void AssimpLoader::updateMaterialBuffer() {
+    if (!mMaterialsDirty)
+        return;
+    mMaterialsDirty = false;
+
+    // materials edited since load may no longer match the entry their meshes share
+    mMaterials.clear();
+    mMaterialIndices.clear();
+    for (const AssimpMeshRef& assimpMeshRef : mModelMeshes) {
+        assignMaterialIndex(assimpMeshRef.get(), assimpMeshRef->mAiMesh->mMaterialIndex);
+    }
+    for (const AssimpMeshRef& assimpMeshRef : mBatchedMeshes) {
+        assignMaterialIndex(assimpMeshRef.get(), assimpMeshRef->mAiMesh->mMaterialIndex);
+    }
+    if (!mMaterialUbo)
+        return;
+
+    if (mMaterials.size() > MaxUniformMaterials) {
+        CI_LOG_I("Edited materials no longer fit into the material buffer; setting material uniforms per mesh.");
+        mMaterialUbo.reset();
+        createShaders();
+        pruneBatches();
+        return;
+    }
+    const std::vector<vec4> materials = packMaterials(mMaterials);
+    mMaterialUbo->bufferSubData(0, materials.size() * sizeof(vec4), materials.data());
+}
+
+void AssimpLoader::applyMaterial(const gl::GlslProgRef& shader, const AssimpMesh* assimpMesh) {
+    if (mMaterialUbo) {
+        shader->uniform("materialIndex", static_cast<int>(assimpMesh->mMaterialIndex));
+        return;
+    }
+    shader->uniform("diffuseColor", assimpMesh->mMaterial.mDiffuse);
+    shader->uniform("specularColor", assimpMesh->mMaterial.mSpecular);
+    shader->uniform("ambientColor", assimpMesh->mMaterial.mAmbient);
+    shader->uniform("emissionColor", assimpMesh->mMaterial.mEmission);
+    shader->uniform("Ns", assimpMesh->mMaterial.mShininess);
+}
+
+void AssimpLoader::drawMesh(AssimpMeshRef mesh) {
+    if (!mesh->mShowMesh)
+        return;
+    updateMaterialBuffer();
+
+    // the mesh is drawn wherever draw() draws it: at every node still holding it, and from the
+    // ranges of the merged mesh the static nodes' copies went into
+    std::vector<RenderItem> items;
+    for (const AssimpNodeRef& nodeRef : mMeshNodes) {
+        for (const AssimpMeshRef& assimpMeshRef : nodeRef->getMeshes()) {
+            if (assimpMeshRef == mesh) {
+                RenderItem item = makeRenderItem(mesh);
+                item.mNode = getPlacingNode(*nodeRef, mesh.get());
+                items.push_back(item);
+            }
+        }
+    }
+    if (mesh->mBatch) {
+        for (const MeshRange& range : mesh->mBatch->mRanges) {
+            if (range.mMesh == mesh.get()) {
+                RenderItem item = makeRenderItem(mesh->mBatch);
+                item.mNode = getPlacingNode(*mNodes.front(), mesh->mBatch.get());
+                item.mFirstIndex = range.mFirstIndex;
+                item.mNumIndices = range.mNumIndices;
+                items.push_back(item);
+            }
+        }
+    }
+    if (items.empty()) {
+        // a mesh no node references
+        items.push_back(makeRenderItem(mesh));
+    }
+    submitRenderItems(items.data(), items.size());
+}
+
+RenderItem AssimpLoader::makeRenderItem(const AssimpMeshRef& assimpMeshRef, bool instanced, bool tinted) {
+    RenderItem item;
+    item.mMesh = assimpMeshRef;
+    // FIXME: inherited from the original drawMesh(), which culls two-sided meshes and leaves one-sided
+    // ones unculled; kept as is so the render queue draws exactly what drawMesh() drew
+    item.mCullFace = assimpMeshRef->mTwoSided;
+
+    ci::gl::ShaderDef shaderDef = ci::gl::ShaderDef().lambert().color();
+    if (mTexturesEnabled && assimpMeshRef->mTexture) {
+        shaderDef.texture();
+        item.mTexture = assimpMeshRef->mTexture;
+    }
+
+    // select the appropriate shader
+    if (assimpMeshRef->mShader) {
+        item.mShader = assimpMeshRef->mShader;
+    } else if (mCustomShaderEnabled && mCustomShaderProgram != nullptr) {
+        item.mShader = mCustomShaderProgram;
+    } else if (instanced) {
+        // the stock shaders can't place instances; like mPhongShaderProgram, the phong variants
+        // don't sample textures
         if (mMaterialsEnabled) {
-            mPhongShaderProgram->uniform("diffuseColor", mesh->mMaterial.mDiffuse);
-            mPhongShaderProgram->uniform("specularColor", mesh->mMaterial.mSpecular);
-            mPhongShaderProgram->uniform("ambientColor", mesh->mMaterial.mAmbient);
-            mPhongShaderProgram->uniform("emissionColor", mesh->mMaterial.mEmission);
-            mPhongShaderProgram->uniform("Ns", mesh->mMaterial.mShininess);
-        }
-
-        // select the appropriate shader
-        if (mCustomShaderEnabled && mCustomShaderProgram != nullptr) {
-            mCustomShaderProgram->bind();
-        } else if (mMaterialsEnabled) {
-            mPhongShaderProgram->bind();
+            item.mShader = tinted ? mInstancedTintPhongShaderProgram : mInstancedPhongShaderProgram;
+        } else if (item.mTexture) {
+            item.mShader = tinted ? mInstancedTintTextureShaderProgram : mInstancedTextureShaderProgram;
         } else {
-            ci::gl::getStockShader(shaderDef)->bind();
+            item.mShader = tinted ? mInstancedTintShaderProgram : mInstancedShaderProgram;
+        }
+    } else if (mMaterialsEnabled) {
+        item.mShader = mPhongShaderProgram;
+    } else {
+        item.mShader = ci::gl::getStockShader(shaderDef);
+    }
+    item.mMaterialUniforms = mMaterialsEnabled && (item.mShader == mPhongShaderProgram ||
+                                                   item.mShader == mInstancedPhongShaderProgram ||
+                                                   item.mShader == mInstancedTintPhongShaderProgram);
+
+    return item;
+}
+
+void AssimpLoader::submitRenderItems(const RenderItem* items, size_t count, GLsizei numInstances) {
+    // only what differs from the previous draw is changed; culling is restored afterwards
+    RenderQueue::Stats stats;
+    gl::ScopedState cullState(GL_CULL_FACE, false);
+    if (mMaterialUbo) {
+        mMaterialUbo->bindBufferBase(MaterialBufferBinding);
+    }
+    const gl::GlslProg* program = nullptr;
+    gl::Texture2dRef texture;
+    bool cullFace = false;
+    int64_t material = -1;
+
+    for (size_t i = 0; i < count; ++i) {
+        const RenderItem& item = items[i];
+        const AssimpMeshRef& mesh = item.mMesh;
+        if (!mesh->mShowMesh)
+            continue;
+
+        // bind the program ourselves, so the batch doesn't switch back to the previous one
+        // after every draw
+        if (item.mShader.get() != program) {
+            item.mShader->bind();
+            program = item.mShader.get();
+            material = -1;
+            ++stats.mNumProgramChanges;
         }
 
-        ci::gl::draw(*(mesh->mCachedTriMesh));
+        if (item.mTexture != texture) {
+            if (texture) {
+                texture->unbind();
+            }
+            if (item.mTexture) {
+                item.mTexture->bind();
+            }
+            texture = item.mTexture;
+            ++stats.mNumTextureChanges;
+        }
 
-        if (mTexturesEnabled && mesh->mTexture) {
-            mesh->mTexture->unbind();
+        if (item.mCullFace != cullFace) {
+            if (item.mCullFace) {
+                gl::enable(GL_CULL_FACE);
+            } else {
+                gl::disable(GL_CULL_FACE);
+            }
+            cullFace = item.mCullFace;
+            ++stats.mNumCullChanges;
+        }
+
+        if (item.mMaterialUniforms && item.mMaterial != material) {
+            applyMaterial(item.mShader, mesh.get());
+            material = item.mMaterial;
+            ++stats.mNumMaterialChanges;
         }
 
-        if (mesh->mTwoSided) {
-            gl::disable(GL_CULL_FACE);
+        // stock instanced shaders apply the node before the instance matrix; everything else
+        // through the model matrix
+        gl::ScopedModelMatrix scopedModelMatrix;
+        const mat4 nodeTransform = item.mNode != InvalidNodeHandle ? mHierarchy->getDerivedTransform(item.mNode) : mat4(1);
+        if (numInstances > 0) {
+            const GLint location = item.mShader->getUniformLocation("uNodeMatrix");
+            if (location >= 0) {
+                item.mShader->uniform(location, nodeTransform);
+            }
+        } else if (item.mNode != InvalidNodeHandle) {
+            gl::multModelMatrix(nodeTransform);
         }
+
+        uploadMesh(mesh.get());
+        gl::BatchRef batch = getBatch(mesh.get(), item.mShader);
+        if (item.mNumIndices > 0) {
+            drawBatchRange(batch, item.mFirstIndex, item.mNumIndices, numInstances);
+            ++stats.mNumDraws;
+        } else if (!mesh->mRanges.empty()) {
+            // merged meshes skip their hidden ranges; neighbouring visible ranges are drawn together
+            const std::vector<MeshRange>& ranges = mesh->mRanges;
+            for (size_t r = 0; r < ranges.size();) {
+                if (!ranges[r].mMesh->mShowMesh) {
+                    ++r;
+                    continue;
+                }
+                const uint32_t first = ranges[r].mFirstIndex;
+                uint32_t count = 0;
+                for (; r < ranges.size() && ranges[r].mMesh->mShowMesh; ++r) {
+                    count += ranges[r].mNumIndices;
+                }
+                drawBatchRange(batch, first, count, numInstances);
+                ++stats.mNumDraws;
+            }
+        } else if (numInstances > 0) {
+            batch->drawInstanced(numInstances);
+            ++stats.mNumDraws;
+        } else {
+            batch->draw();
+            ++stats.mNumDraws;
+        }
+    }
+
+    if (texture) {
+        texture->unbind();
     }
+    mRenderStats = stats;
 }
 
 AssimpLoader::AssimpLoader()
-    : mMaterialsEnabled(false),
+    : mPoseVersion(0),
+      mMaterialsEnabled(false),
       mTexturesEnabled(true),
       mSkinningEnabled(false),
+      mSparseSkinningEnabled(false),
+      mSparseSkinningThreshold(0.5f),
       mAnimationEnabled(false),
       mCustomShaderEnabled(false),
       mAnimationIndex(0),
       mAnimationTime(0),
-      mCustomShaderProgram(nullptr) {}
+      mAppliedPoseVersion(NotApplied),
+      mAppliedAnimationIndex(0),
+      mAppliedAnimationTime(0),
+      mCustomPose(false),
+      mPoseCacheModel(0),
+      mCustomShaderProgram(nullptr),
+      mUploadBytes(0),
+      mRenderQueue(RenderQueue::create()),
+      mRenderQueueDirty(true),
+      mInstancedQueue(RenderQueue::create()),
+      mInstancedQueueDirty(true),
+      mInstancedQueueTinted(false),
+      mStaticMergingEnabled(false),
+      mStaticBatchingEnabled(false),
+      mMaterialsDirty(false),
+      mGpuResourcesEnabled(true),
+      mTexturePackingEnabled(false),
+      mAtlasSize(2048) {}
 
 AssimpLoader::AssimpLoader(const std::filesystem::path& filename) : AssimpLoader() {
     setFilename(filename);
@@ -503,11 +1068,247 @@ void AssimpLoader::loadAllMeshes()
 	CI_LOG_D("Finished loading model " << mFilePath.filename().string());
 }
 
+void AssimpLoader::resolveAnimationChannels()
+{
+	// look up the target node of every channel once, instead of by name every frame
+	mAnimationChannelNodes.resize( mScene->mNumAnimations );
+	for ( unsigned i = 0; i < mScene->mNumAnimations; ++i )
+	{
+		const aiAnimation *anim = mScene->mAnimations[ i ];
+		mAnimationChannelNodes[ i ].resize( anim->mNumChannels );
+		for ( unsigned a = 0; a < anim->mNumChannels; ++a )
+		{
+			NodeHandle node = mHierarchy->findNode( anim->mChannels[ a ]->mNodeName.C_Str() );
+			if ( node == InvalidNodeHandle )
+				CI_LOG_W( "Animation " << i << " targets unknown node " << fromAssimp( anim->mChannels[ a ]->mNodeName ) );
+			mAnimationChannelNodes[ i ][ a ] = node;
+		}
+	}
+
+	// morph channels name either the animated meshes or the node holding them
+	mAnimationMorphMeshes.resize( mScene->mNumAnimations );
+	for ( unsigned i = 0; i < mScene->mNumAnimations; ++i )
+	{
+		const aiAnimation *anim = mScene->mAnimations[ i ];
+		mAnimationMorphMeshes[ i ].resize( anim->mNumMorphMeshChannels );
+		for ( unsigned a = 0; a < anim->mNumMorphMeshChannels; ++a )
+		{
+			const string name = fromAssimp( anim->mMorphMeshChannels[ a ]->mName );
+			vector< AssimpMesh* > &meshes = mAnimationMorphMeshes[ i ][ a ];
+			for ( const AssimpMeshRef &assimpMeshRef : mModelMeshes )
+			{
+				if ( assimpMeshRef->mName == name && !assimpMeshRef->mMorphTargets.empty() )
+					meshes.push_back( assimpMeshRef.get() );
+			}
+
+			NodeHandle node = mHierarchy->findNode( name );
+			if ( meshes.empty() && node != InvalidNodeHandle )
+			{
+				for ( const AssimpMeshRef &assimpMeshRef : mHierarchy->getMeshes( node ) )
+				{
+					if ( !assimpMeshRef->mMorphTargets.empty() )
+						meshes.push_back( assimpMeshRef.get() );
+				}
+			}
+
+			if ( meshes.empty() )
+				CI_LOG_W( "Animation " << i << " morphs unknown mesh " << name );
+		}
+	}
+}
+
+void AssimpLoader::batchStaticMeshes()
+{
+	// nodes moved by an animation keep their meshes, and so do the nodes below them; parents
+	// precede their children, so one pass propagates the flag
+	vector< uint8_t > animated( mHierarchy->getNumNodes(), 0 );
+	for ( const vector< NodeHandle > &channelNodes : mAnimationChannelNodes )
+	{
+		for ( NodeHandle node : channelNodes )
+		{
+			if ( node != InvalidNodeHandle )
+				animated[ node ] = 1;
+		}
+	}
+	for ( size_t i = 0; i < animated.size(); ++i )
+	{
+		int parent = mHierarchy->getParent( i );
+		if ( parent >= 0 && animated[ parent ] )
+			animated[ i ] = 1;
+	}
+
+	vector< aiMatrix4x4 > transforms;
+	collectNodeTransforms( mScene->mRootNode, aiMatrix4x4(), &transforms );
+
+	// collect the static meshes of every node by material, taking them off their nodes
+	struct Part {
+		AssimpMeshRef mMesh;
+		size_t mNode;
+	};
+	std::map< unsigned, vector< Part > > materialParts;
+	for ( size_t i = 0; i < mNodes.size(); ++i )
+	{
+		if ( animated[ i ] )
+			continue;
+
+		vector< AssimpMeshRef > &meshes = mNodes[ i ]->getMeshes();
+		vector< AssimpMeshRef > kept;
+		for ( const AssimpMeshRef &assimpMeshRef : meshes )
+		{
+			if ( assimpMeshRef->mAiMesh->HasBones() || !assimpMeshRef->mMorphTargets.empty() )
+				kept.push_back( assimpMeshRef );
+			else
+				materialParts[ assimpMeshRef->mAiMesh->mMaterialIndex ].push_back( { assimpMeshRef, i } );
+		}
+		meshes.swap( kept );
+	}
+	if ( materialParts.empty() )
+		return;
+
+	for ( auto &material : materialParts )
+	{
+		const vector< Part > &parts = material.second;
+		unsigned numVertices = 0;
+		unsigned numFaces = 0;
+		bool hasNormals = false;
+		bool hasTexCoords = false;
+		bool hasColors = false;
+		for ( const Part &part : parts )
+		{
+			const aiMesh *mesh = part.mMesh->mAiMesh;
+			numVertices += mesh->mNumVertices;
+			numFaces += mesh->mNumFaces;
+			hasNormals |= mesh->HasNormals();
+			hasTexCoords |= mesh->HasTextureCoords( 0 );
+			hasColors |= mesh->HasVertexColors( 0 );
+		}
+
+		// merged meshes are regular aiMeshes, so they load like any other mesh
+		std::unique_ptr< aiMesh > merged( new aiMesh() );
+		merged->mName = aiString( parts.front().mMesh->mMaterial.mName + " (batched)" );
+		merged->mMaterialIndex = material.first;
+		merged->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+		merged->mNumVertices = numVertices;
+		merged->mVertices = new aiVector3D[ numVertices ];
+		if ( hasNormals )
+			merged->mNormals = new aiVector3D[ numVertices ];
+		if ( hasTexCoords )
+		{
+			merged->mTextureCoords[ 0 ] = new aiVector3D[ numVertices ];
+			merged->mNumUVComponents[ 0 ] = 2;
+		}
+		if ( hasColors )
+			merged->mColors[ 0 ] = new aiColor4D[ numVertices ];
+		merged->mNumFaces = numFaces;
+		merged->mFaces = new aiFace[ numFaces ];
+
+		vector< MeshRange > ranges;
+		unsigned baseVertex = 0;
+		unsigned face = 0;
+		uint32_t index = 0;
+		for ( const Part &part : parts )
+		{
+			const aiMesh *mesh = part.mMesh->mAiMesh;
+			const aiMatrix4x4 &transform = transforms[ part.mNode ];
+			aiMatrix3x3 normalMatrix = aiMatrix3x3( transform );
+			normalMatrix.Inverse().Transpose();
+
+			for ( unsigned v = 0; v < mesh->mNumVertices; ++v )
+			{
+				merged->mVertices[ baseVertex + v ] = transform * mesh->mVertices[ v ];
+				if ( hasNormals )
+					merged->mNormals[ baseVertex + v ] = mesh->HasNormals() ? ( normalMatrix * mesh->mNormals[ v ] ).Normalize() : aiVector3D( 0, 0, 1 );
+				if ( hasTexCoords )
+					merged->mTextureCoords[ 0 ][ baseVertex + v ] = mesh->HasTextureCoords( 0 ) ? mesh->mTextureCoords[ 0 ][ v ] : aiVector3D( 0 );
+				if ( hasColors )
+					merged->mColors[ 0 ][ baseVertex + v ] = mesh->HasVertexColors( 0 ) ? mesh->mColors[ 0 ][ v ] : aiColor4D( 1, 1, 1, 1 );
+			}
+
+			MeshRange range;
+			range.mMesh = part.mMesh.get();
+			range.mFirstIndex = index;
+			for ( unsigned f = 0; f < mesh->mNumFaces; ++f, ++face )
+			{
+				const aiFace &source = mesh->mFaces[ f ];
+				aiFace &target = merged->mFaces[ face ];
+				target.mNumIndices = source.mNumIndices;
+				target.mIndices = new unsigned[ source.mNumIndices ];
+				for ( unsigned a = 0; a < source.mNumIndices; ++a )
+					target.mIndices[ a ] = source.mIndices[ a ] + baseVertex;
+				index += source.mNumIndices;
+			}
+			range.mNumIndices = index - range.mFirstIndex;
+			ranges.push_back( range );
+			baseVertex += mesh->mNumVertices;
+		}
+
+		AssimpMeshRef batchRef = convertAiMesh( merged.get() );
+		batchRef->mTexture = parts.front().mMesh->mTexture;
+		batchRef->mRanges = ranges;
+		for ( const Part &part : parts )
+			part.mMesh->mBatch = batchRef;
+
+		mNodes.front()->getMeshes().push_back( batchRef );
+		mBatchedMeshes.push_back( batchRef );
+		mBatchedAiMeshes.push_back( std::move( merged ) );
+		CI_LOG_D( "Batched " << parts.size() << " meshes into " << batchRef->mName );
+	}
+
+	// nodes may have lost all of their meshes, the root may have gained some
+	mMeshNodes.clear();
+	for ( const AssimpNodeRef &nodeRef : mNodes )
+	{
+		if ( !nodeRef->getMeshes().empty() )
+			mMeshNodes.push_back( nodeRef );
+	}
+
+}
+
+void AssimpLoader::resolveSkeleton()
+{
+	// bones of different meshes often share nodes; give every node a single palette entry
+	std::unordered_map< NodeHandle, uint32_t > paletteIndices;
+	mSkeletonNodes.clear();
+	for ( const AssimpMeshRef& assimpMeshRef : mModelMeshes )
+	{
+		const aiMesh *mesh = assimpMeshRef->mAiMesh;
+		assimpMeshRef->mBonePaletteIndices.resize( mesh->mNumBones );
+		assimpMeshRef->mBoneOffsets.resize( mesh->mNumBones );
+		assimpMeshRef->mBoneMatrices.resize( mesh->mNumBones );
+		for ( unsigned a = 0; a < mesh->mNumBones; ++a )
+		{
+			const aiBone *bone = mesh->mBones[ a ];
+			NodeHandle node = mHierarchy->findNode( bone->mName.C_Str() );
+			if ( node == InvalidNodeHandle )
+				CI_LOG_W( "Bone " << fromAssimp( bone->mName ) << " of mesh " << assimpMeshRef->mName << " has no node" );
+
+			auto inserted = paletteIndices.emplace( node, static_cast< uint32_t >( mSkeletonNodes.size() ) );
+			if ( inserted.second )
+				mSkeletonNodes.push_back( node );
+
+			assimpMeshRef->mBonePaletteIndices[ a ] = inserted.first->second;
+			assimpMeshRef->mBoneOffsets[ a ] = bone->mOffsetMatrix;
+		}
+	}
+
+	// entries without a node stay at identity; every mesh is skinned on the first update
+	mSkeletonPalette.assign( mSkeletonNodes.size(), aiMatrix4x4() );
+	mPoseVersion = 1;
+	mSkeletonVersions.assign( mSkeletonNodes.size(), mPoseVersion );
+}
+
 void AssimpLoader::updateAnimation( size_t animationIndex, double currentTime )
 {
     if (mScene->mNumAnimations == 0)
         return;
 
+    sampleAnimation(animationIndex, currentTime, mChannelPoses);
+    applyChannelPoses(animationIndex, mChannelPoses);
+    updateMorphAnimation(animationIndex, currentTime);
+}
+
+void AssimpLoader::sampleAnimation( size_t animationIndex, double currentTime, std::vector<NodePose>& poses ) const
+{
     const aiAnimation* mAnim = mScene->mAnimations[animationIndex];
     double ticks = mAnim->mTicksPerSecond;
     if (ticks == 0.0)
@@ -515,10 +1316,13 @@ void AssimpLoader::updateAnimation( size_t animationIndex, double currentTime )
     currentTime *= ticks;
 
     // calculate the transformations for each animation channel
+    poses.resize(mAnim->mNumChannels);
     for (unsigned int a = 0; a < mAnim->mNumChannels; a++) {
         const aiNodeAnim* channel = mAnim->mChannels[a];
 
-        AssimpNodeRef targetNode = getAssimpNode(fromAssimp(channel->mNodeName));
+        NodeHandle targetNode = mAnimationChannelNodes[animationIndex][a];
+        if (targetNode == InvalidNodeHandle)
+            continue;
 
         // ******** Position *****
         aiVector3D presentPosition(0, 0, 0);
@@ -586,39 +1390,132 @@ void AssimpLoader::updateAnimation( size_t animationIndex, double currentTime )
             presentScaling = channel->mScalingKeys[frame].mValue;
         }
 
-        targetNode->setOrientation(fromAssimp(presentRotation));
-        targetNode->setScale(fromAssimp(presentScaling));
-        targetNode->setPosition(fromAssimp(presentPosition));
+        NodePose& pose = poses[a];
+        pose.mPosition = fromAssimp(presentPosition);
+        pose.mOrientation = fromAssimp(presentRotation);
+        pose.mScale = fromAssimp(presentScaling);
+    }
+}
+
+void AssimpLoader::applyChannelPoses( size_t animationIndex, const std::vector<NodePose>& poses )
+{
+    // one write and one invalidation per channel; the derived transforms are recomputed in
+    // a single sweep the next time they are queried
+    const std::vector<NodeHandle>& targetNodes = mAnimationChannelNodes[animationIndex];
+    for (size_t a = 0; a < targetNodes.size() && a < poses.size(); ++a) {
+        if (targetNodes[a] != InvalidNodeHandle)
+            mHierarchy->setLocalPose(targetNodes[a], poses[a]);
+    }
+}
+
+void AssimpLoader::updateMorphAnimation( size_t animationIndex, double currentTime )
+{
+    const aiAnimation* mAnim = mScene->mAnimations[animationIndex];
+    double ticks = mAnim->mTicksPerSecond;
+    if (ticks == 0.0)
+        ticks = 1.0;
+    currentTime *= ticks;
+
+    // ******** Morph weights **********
+    for (unsigned int a = 0; a < mAnim->mNumMorphMeshChannels; a++) {
+        const aiMeshMorphAnim* channel = mAnim->mMorphMeshChannels[a];
+        if (channel->mNumKeys == 0)
+            continue;
+
+        unsigned int frame = 0;
+        while (frame < channel->mNumKeys - 1) {
+            if (currentTime < channel->mKeys[frame + 1].mTime)
+                break;
+            frame++;
+        }
+
+        // every key lists the weights of its targets; blend this key's with the next key's
+        unsigned int nextFrame = (frame + 1) % channel->mNumKeys;
+        const aiMeshMorphKey& key = channel->mKeys[frame];
+        const aiMeshMorphKey& nextKey = channel->mKeys[nextFrame];
+        double diffTime = nextKey.mTime - key.mTime;
+        if (diffTime < 0.0)
+            diffTime += mAnim->mDuration;
+        float factor = diffTime > 0 ? float((currentTime - key.mTime) / diffTime) : 0.0f;
+
+        for (AssimpMesh* mesh : mAnimationMorphMeshes[animationIndex][a]) {
+            mMorphChannelWeights.assign(mesh->mMorphTargets.size(), 0.0f);
+            for (unsigned int k = 0; k < key.mNumValuesAndWeights; ++k) {
+                if (key.mValues[k] < mMorphChannelWeights.size())
+                    mMorphChannelWeights[key.mValues[k]] += float(key.mWeights[k]) * (1.0f - factor);
+            }
+            for (unsigned int k = 0; k < nextKey.mNumValuesAndWeights; ++k) {
+                if (nextKey.mValues[k] < mMorphChannelWeights.size())
+                    mMorphChannelWeights[nextKey.mValues[k]] += float(nextKey.mWeights[k]) * factor;
+            }
+
+            if (mMorphChannelWeights != mesh->mMorphWeights) {
+                mesh->mMorphWeights = mMorphChannelWeights;
+                mesh->mMorphDirty = true;
+            }
+        }
     }
 }
 
+NodeHandle AssimpLoader::findNode( const std::string &name ) const
+{
+	if ( !mHierarchy )
+		return InvalidNodeHandle;
+	return mHierarchy->findNode( name );
+}
+
+const std::vector< std::string > &AssimpLoader::getNodeNames() const
+{
+	static const std::vector< std::string > noNames;
+	return mHierarchy ? mHierarchy->getNames() : noNames;
+}
+
 AssimpNodeRef AssimpLoader::getAssimpNode( const std::string &name )
 {
-	map< string, AssimpNodeRef >::iterator i = mNodeMap.find( name );
-	if ( i != mNodeMap.end() )
-		return i->second;
+	return getAssimpNode( findNode( name ) );
+}
+
+const AssimpNodeRef AssimpLoader::getAssimpNode( const std::string &name ) const
+{
+	return getAssimpNode( findNode( name ) );
+}
+
+AssimpNodeRef AssimpLoader::getAssimpNode( NodeHandle node )
+{
+	if ( node >= 0 && static_cast< size_t >( node ) < mNodes.size() )
+		return mNodes[ node ];
 	else
 		return AssimpNodeRef();
 }
 
-const AssimpNodeRef AssimpLoader::getAssimpNode( const std::string &name ) const
+const AssimpNodeRef AssimpLoader::getAssimpNode( NodeHandle node ) const
 {
-	map< string, AssimpNodeRef >::const_iterator i = mNodeMap.find( name );
-	if ( i != mNodeMap.end() )
-		return i->second;
+	if ( node >= 0 && static_cast< size_t >( node ) < mNodes.size() )
+		return mNodes[ node ];
 	else
 		return AssimpNodeRef();
 }
 
 size_t AssimpLoader::getAssimpNodeNumMeshes( const string &name )
 {
-	AssimpNodeRef node = getAssimpNode( name );
-	if ( node )
-		return node->getMeshes().size();
+	return getAssimpNodeNumMeshes( findNode( name ) );
+}
+
+size_t AssimpLoader::getAssimpNodeNumMeshes( NodeHandle node )
+{
+	AssimpNodeRef nodeRef = getAssimpNode( node );
+	if ( nodeRef )
+		return nodeRef->getMeshes().size();
 	else
 		return 0;
 }
 
+NodeHandle AssimpLoader::getMeshNode( size_t n ) const
+{
+	const AssimpMeshRef &assimpMeshRef = mModelMeshes[ n ];
+	return assimpMeshRef->mAiMesh->HasBones() ? InvalidNodeHandle : assimpMeshRef->mNode;
+}
+
 TriMeshRef AssimpLoader::getAssimpNodeMesh( const string &name, size_t n /* = 0 */ )
 {
 	AssimpNodeRef node = getAssimpNode( name );
@@ -637,6 +1534,15 @@ const TriMeshRef AssimpLoader::getAssimpNodeMesh( const string &name, size_t n /
 		throw AssimpLoaderExc( "node " + name + " not found." );
 }
 
+TriMeshRef AssimpLoader::getAssimpNodeMesh( NodeHandle node, size_t n /* = 0 */ )
+{
+	AssimpNodeRef nodeRef = getAssimpNode( node );
+	if ( nodeRef && n < nodeRef->getMeshes().size() )
+		return nodeRef->getMeshes()[n]->mCachedTriMesh;
+	else
+		throw AssimpLoaderExc( "node #" + toString< NodeHandle >( node ) + " not found." );
+}
+
 gl::Texture2dRef &AssimpLoader::getAssimpNodeTexture( const string &name, size_t n /* = 0 */ )
 {
 	AssimpNodeRef node = getAssimpNode( name );
@@ -655,6 +1561,15 @@ const gl::Texture2dRef &AssimpLoader::getAssimpNodeTexture( const string &name,
 		throw AssimpLoaderExc( "node " + name + " not found." );
 }
 
+gl::Texture2dRef &AssimpLoader::getAssimpNodeTexture( NodeHandle node, size_t n /* = 0 */ )
+{
+	AssimpNodeRef nodeRef = getAssimpNode( node );
+	if ( nodeRef && n < nodeRef->getMeshes().size() )
+		return nodeRef->getMeshes()[n]->mTexture;
+	else
+		throw AssimpLoaderExc( "node #" + toString< NodeHandle >( node ) + " not found." );
+}
+
 /*
 Material& AssimpLoader::getAssimpNodeMaterial(const std::string& name, size_t n) {
 	// TODO: insert return statement here
@@ -667,16 +1582,28 @@ const Material& AssimpLoader::getAssimpNodeMaterial(const std::string& name, siz
 
 void AssimpLoader::setNodeOrientation( const string &name, const quat &rot )
 {
-	AssimpNodeRef node = getAssimpNode( name );
-	if ( node )
-		node->setOrientation( rot );
+	setNodeOrientation( findNode( name ), rot );
+}
+
+void AssimpLoader::setNodeOrientation( NodeHandle node, const quat &rot )
+{
+	if ( node >= 0 && static_cast< size_t >( node ) < mHierarchy->getNumNodes() )
+	{
+		// an animated node gets its animated orientation back on the next update
+		mHierarchy->setOrientation( node, rot );
+		mCustomPose = true;
+	}
 }
 
 quat AssimpLoader::getNodeOrientation( const string &name )
 {
-	AssimpNodeRef node = getAssimpNode( name );
-	if ( node )
-		return node->getOrientation();
+	return getNodeOrientation( findNode( name ) );
+}
+
+quat AssimpLoader::getNodeOrientation( NodeHandle node ) const
+{
+	if ( node >= 0 && static_cast< size_t >( node ) < mHierarchy->getNumNodes() )
+		return mHierarchy->getOrientation( node );
 	else
 		return quat();
 }
@@ -714,85 +1641,198 @@ double AssimpLoader::getAnimationDuration( size_t n ) const
 	return anim->mDuration / ticks;
 }
 
-void AssimpLoader::updateSkinning()
+void AssimpLoader::setMorphWeight( size_t n, size_t target, float weight )
 {
-    vector<AssimpNodeRef>::const_iterator it = mMeshNodes.begin();
-    for (; it != mMeshNodes.end(); ++it) {
-        AssimpNodeRef nodeRef = *it;
+	AssimpMeshRef assimpMeshRef = mModelMeshes[ n ];
+	if ( assimpMeshRef->mMorphWeights[ target ] != weight )
+	{
+		assimpMeshRef->mMorphWeights[ target ] = weight;
+		assimpMeshRef->mMorphDirty = true;
+	}
+}
+
+void AssimpLoader::updateMorphTargets()
+{
+    // only meshes whose weights changed are blended; collecting them first keeps the pool from
+    // queueing a task for every mesh of the model
+    mMorphJobs.clear();
+    for (const AssimpMeshRef& assimpMeshRef : mModelMeshes) {
+        if (assimpMeshRef->mMorphDirty)
+            mMorphJobs.push_back(assimpMeshRef.get());
+    }
+    if (mMorphJobs.empty())
+        return;
 
-        vector<AssimpMeshRef>::const_iterator meshIt = nodeRef->getMeshes().begin();
-        for (; meshIt != nodeRef->getMeshes().end(); ++meshIt) {
-            AssimpMeshRef assimpMeshRef = *meshIt;
+    // meshes are independent, so they are blended in parallel; the blend itself writes
+    // overlapping four-float groups and stays serial within a mesh
+    const SkinningKernel kernel = mSkinningKernel ? *mSkinningKernel : sitara::assimp::getSkinningKernel();
+    auto morphMesh = [this, kernel](size_t i) {
+        AssimpMesh* assimpMesh = mMorphJobs[i];
+        const aiMesh* mesh = assimpMesh->mAiMesh;
+        float* positions = assimpMesh->mMorphedPositions.data();
+        float* normals = mesh->HasNormals() ? assimpMesh->mMorphedNormals.data() : nullptr;
+        memcpy(positions, mesh->mVertices, mesh->mNumVertices * sizeof(aiVector3D));
+        if (normals)
+            memcpy(normals, mesh->mNormals, mesh->mNumVertices * sizeof(aiVector3D));
+
+        for (size_t t = 0; t < assimpMesh->mMorphTargets.size(); ++t) {
+            applyMorphTarget(kernel, assimpMesh->mMorphTargets[t], assimpMesh->mMorphWeights[t], positions, normals);
+        }
+
+        // the mesh has to be skinned again, or restored from the new morphed vertices
+        assimpMesh->mMorphDirty = false;
+        assimpMesh->mValidCache = false;
+    };
 
-            // current mesh we are introspecting
-            const aiMesh* mesh = assimpMeshRef->mAiMesh;
+    if (mThreadPool && mMorphJobs.size() > 1) {
+        mThreadPool->parallelFor(mMorphJobs.size(), morphMesh);
+    } else {
+        for (size_t i = 0; i < mMorphJobs.size(); ++i) {
+            morphMesh(i);
+        }
+    }
+}
 
-            // calculate bone matrices
-            std::vector<aiMatrix4x4> boneMatrices(mesh->mNumBones);
+void AssimpLoader::updateSkeletonPalette()
+{
+    // another loader of the same model may already have computed this pose's palette
+    const std::vector<aiMatrix4x4>* cachedPalette = nullptr;
+    if (mPoseCacheEntry && !mCustomPose && mPoseCacheEntry->mPalette.size() == mSkeletonPalette.size()) {
+        cachedPalette = &mPoseCacheEntry->mPalette;
+    }
+
+    // every skeleton node is converted once per frame, however many meshes it deforms; entries
+    // that actually changed are stamped with the new pose version
+    ++mPoseVersion;
+    for (size_t i = 0; i < mSkeletonNodes.size(); ++i) {
+        if (mSkeletonNodes[i] == InvalidNodeHandle) {
+            continue;
+        }
+        aiMatrix4x4 m = cachedPalette ? (*cachedPalette)[i] : toAssimp(mHierarchy->getDerivedTransform(mSkeletonNodes[i]));
+        if (memcmp(&m, &mSkeletonPalette[i], sizeof(aiMatrix4x4)) != 0) {
+            mSkeletonPalette[i] = m;
+            mSkeletonVersions[i] = mPoseVersion;
+        }
+    }
+}
+
+void AssimpLoader::updateSkinning()
+{
+    // bone matrices come first and serially: they read the node hierarchy, which updates lazily
+    updateSkeletonPalette();
+
+    mSkinningJobs.clear();
+    for (const AssimpMeshRef& assimpMeshRef : mModelMeshes) {
+        // current mesh we are introspecting
+        const aiMesh* mesh = assimpMeshRef->mAiMesh;
+        if (mesh->mNumBones == 0)
+            continue;
+
+        // keep the skinned vertices of meshes whose bones didn't move
+        const bool canSkinSparse = mSparseSkinningEnabled && !assimpMeshRef->mBoneVertices.empty();
+        bool sparse = false;
+        if (assimpMeshRef->mValidCache) {
+            size_t numMoved = 0;
+            size_t numMovedVertices = 0;
             for (unsigned a = 0; a < mesh->mNumBones; ++a) {
-                const aiBone* bone = mesh->mBones[a];
-
-                // find the corresponding node by again looking recursively through
-                // the node hierarchy for the same name
-                AssimpNodeRef nodeRef = getAssimpNode(fromAssimp(bone->mName));
-                assert(nodeRef);
-                // start with the mesh-to-bone matrix
-                // and append all node transformations down the parent chain until
-                // we're back at mesh coordinates again
-                
-                boneMatrices[a] = toAssimp(nodeRef->getDerivedTransform()) * bone->mOffsetMatrix;
-                
-                /*
-                //! copied from ofAssimpLoader
-                // start with the mesh-to-bone matrix
-                boneMatrices[a] = bone->mOffsetMatrix;
-                // and now append all node transformations down the parent chain until we're back at mesh coordinates
-                // again
-                AssimpNodeRef tempNode = nodeRef;
-                while (tempNode) {
-                    // check your matrix multiplication order here!!!
-                    boneMatrices[a] = toAssimp(tempNode->getDerivedTransform()) * boneMatrices[a];
-                    // boneMatrices[a] = boneMatrices[a] * tempNode->mTransformation;
-                    tempNode = tempNode->getParent();
+                if (mSkeletonVersions[assimpMeshRef->mBonePaletteIndices[a]] > assimpMeshRef->mSkinnedVersion) {
+                    ++numMoved;
+                    if (canSkinSparse)
+                        numMovedVertices += assimpMeshRef->mBoneVertices.getNumVertices(a);
                 }
-                //! end copy from ofAssimpLoader
-                */
-                assimpMeshRef->mValidCache = false;                
             }
+            if (numMoved == 0)
+                continue;
+
+            // vertices shared by several moved bones are counted more than once, which errs
+            // on the side of a full pass
+            sparse = canSkinSparse && numMovedVertices < mSparseSkinningThreshold * mesh->mNumVertices;
+        }
+
+        // start with the mesh-to-bone matrix and append the model space transform of the
+        // bone's node, which brings us back to mesh coordinates
+        for (unsigned a = 0; a < mesh->mNumBones; ++a) {
+            assimpMeshRef->mBoneMatrices[a] = mSkeletonPalette[assimpMeshRef->mBonePaletteIndices[a]] * assimpMeshRef->mBoneOffsets[a];
+        }
 
-            assimpMeshRef->mAnimatedPos.assign(assimpMeshRef->mAnimatedPos.size(), aiVector3D(0, 0, 0));
-            if (mesh->HasNormals()) {
-                assimpMeshRef->mAnimatedNorm.assign(assimpMeshRef->mAnimatedNorm.size(), aiVector3D(0, 0, 0));
+        // every skinned vertex is a weighted average of its bones' transforms, so it lies within
+        // the union of the moved bone boxes
+        if (!assimpMeshRef->mBoneBounds.empty()) {
+            vec3 boundsMin(std::numeric_limits<float>::max());
+            vec3 boundsMax(-std::numeric_limits<float>::max());
+            for (size_t b = 0; b < assimpMeshRef->mBoundedBones.size(); ++b) {
+                uint32_t bone = assimpMeshRef->mBoundedBones[b];
+                includeTransformedBox(mSkeletonPalette[assimpMeshRef->mBonePaletteIndices[bone]], assimpMeshRef->mBoneBounds[b], &boundsMin, &boundsMax);
             }
+            assimpMeshRef->mAnimatedBounds = AxisAlignedBox(boundsMin, boundsMax);
+        }
 
-            // loop through all vertex weights of all bones
-            for (unsigned a = 0; a < mesh->mNumBones; ++a) {
-                const aiBone* bone = mesh->mBones[a];
-                const aiMatrix4x4& posTrafo = boneMatrices[a];
+        if (sparse) {
+            addSparseSkinningJobs(assimpMeshRef.get());
+        } else {
+            // split the mesh into chunks so large meshes spread over all threads
+            size_t numVertices = assimpMeshRef->mBoneInfluences.getNumVertices();
+            for (size_t first = 0; first < numVertices; first += SkinningChunkSize) {
+                SkinningJob job = {assimpMeshRef.get(), first, std::min(SkinningChunkSize, numVertices - first)};
+                mSkinningJobs.push_back(job);
+            }
+        }
 
-                for (unsigned b = 0; b < bone->mNumWeights; ++b) {
-                    const aiVertexWeight& weight = bone->mWeights[b];
-                    size_t vertexId = weight.mVertexId;
-                    const aiVector3D& srcPos = mesh->mVertices[vertexId];
+        // the jobs below write the skinned vertices straight into the TriMesh
+        assimpMeshRef->mValidCache = true;
+        assimpMeshRef->mGpuDirty = true;
+        assimpMeshRef->mSkinnedVersion = mPoseVersion;
+    }
 
-                    assimpMeshRef->mAnimatedPos[vertexId] += weight.mWeight * (posTrafo * srcPos);
-                }
+    // every job writes its own vertices only, so the output doesn't depend on scheduling
+    const SkinningKernel kernel = mSkinningKernel ? *mSkinningKernel : sitara::assimp::getSkinningKernel();
+    auto skinJob = [this, kernel](size_t i) {
+        const SkinningJob& job = mSkinningJobs[i];
+        const aiMesh* mesh = job.mMesh->mAiMesh;
+        TriMeshRef triMesh = job.mMesh->mCachedTriMesh;
+        skinVertices(kernel, job.mMesh->mBoneInfluences, job.mMesh->mBoneMatrices.data(),
+                     job.mMesh->getSourcePositions(), job.mMesh->getSourceNormals(),
+                     &triMesh->getPositions<3>()[0].x,
+                     mesh->HasNormals() ? &triMesh->getNormals()[0].x : nullptr,
+                     job.mFirst, job.mCount);
+    };
+
+    if (mThreadPool) {
+        mThreadPool->parallelFor(mSkinningJobs.size(), skinJob);
+    } else {
+        for (size_t i = 0; i < mSkinningJobs.size(); ++i) {
+            skinJob(i);
+        }
+    }
+}
 
-                if (mesh->HasNormals()) {
-                    // 3x3 matrix, contains the bone matrix without the
-                    // translation, only with rotation and possibly scaling
-                    aiMatrix3x3 normTrafo = aiMatrix3x3(posTrafo);
-                    for (size_t b = 0; b < bone->mNumWeights; ++b) {
-                        const aiVertexWeight& weight = bone->mWeights[b];
-                        size_t vertexId = weight.mVertexId;
-
-                        const aiVector3D& srcNorm = mesh->mNormals[vertexId];
-                        assimpMeshRef->mAnimatedNorm[vertexId] += weight.mWeight * (normTrafo * srcNorm);
-                    }
-                }
-            }
+void AssimpLoader::addSparseSkinningJobs(AssimpMesh* assimpMesh)
+{
+    // gather the vertices of every moved bone; the other vertices keep last frame's output
+    const aiMesh* mesh = assimpMesh->mAiMesh;
+    const BoneVertexLists& lists = assimpMesh->mBoneVertices;
+    mSparseVertices.clear();
+    for (unsigned a = 0; a < mesh->mNumBones; ++a) {
+        if (mSkeletonVersions[assimpMesh->mBonePaletteIndices[a]] > assimpMesh->mSkinnedVersion) {
+            mSparseVertices.insert(mSparseVertices.end(), lists.getVertices(a), lists.getVertices(a) + lists.getNumVertices(a));
         }
     }
+    std::sort(mSparseVertices.begin(), mSparseVertices.end());
+    mSparseVertices.erase(std::unique(mSparseVertices.begin(), mSparseVertices.end()), mSparseVertices.end());
+
+    // turn them into ranges for the contiguous kernels; skinning an unmoved vertex again
+    // reproduces its output, so small gaps are bridged rather than paid for as separate jobs
+    const size_t maxGap = 32;
+    size_t i = 0;
+    while (i < mSparseVertices.size()) {
+        size_t first = mSparseVertices[i];
+        size_t last = first;
+        while (++i < mSparseVertices.size() && mSparseVertices[i] - last <= maxGap && mSparseVertices[i] - first < SkinningChunkSize) {
+            last = mSparseVertices[i];
+        }
+        SkinningJob job = {assimpMesh, first, last - first + 1};
+        mSkinningJobs.push_back(job);
+    }
 }
 
 void AssimpLoader::updateMeshes()
@@ -807,38 +1847,25 @@ void AssimpLoader::updateMeshes()
 		{
 			AssimpMeshRef assimpMeshRef = *meshIt;
 
+			// skinned meshes are written directly by updateSkinning(); anything still invalid
+			// goes back to the original (or morphed) mesh data
 			if ( assimpMeshRef->mValidCache )
 				continue;
 
-			ci::vec3* vertices;
-            size_t numVertices = assimpMeshRef->mCachedTriMesh->getNumVertices();
+			const aiVector3D *sourcePositions = assimpMeshRef->getSourcePositions();
+			const aiVector3D *sourceNormals = assimpMeshRef->getSourceNormals();
+			size_t numVertices = assimpMeshRef->mCachedTriMesh->getNumVertices();
 
-			if ( mSkinningEnabled )
-			{
-				// animated data
-                vertices = assimpMeshRef->mCachedTriMesh->getPositions<3>();
-                for (size_t v = 0; v < numVertices; ++v)
-                    vertices[v] = fromAssimp(assimpMeshRef->mAnimatedPos[v]);
+			ci::vec3* vertices = assimpMeshRef->mCachedTriMesh->getPositions<3>();
+			for ( size_t v = 0; v < numVertices; ++v )
+				vertices[v] = fromAssimp( sourcePositions[ v ] );
 
-                std::vector<ci::vec3>& normals = assimpMeshRef->mCachedTriMesh->getNormals();
-                for (size_t v = 0; v < normals.size(); ++v)
-                    normals[v] = fromAssimp(assimpMeshRef->mAnimatedNorm[v]);
+			std::vector<ci::vec3>& normals = assimpMeshRef->mCachedTriMesh->getNormals();
+			for( size_t v = 0; sourceNormals && v < normals.size(); ++v )
+				normals[v] = fromAssimp( sourceNormals[ v ] );
 
-            }
-			else
-			{
-				// original mesh data from assimp
-				const aiMesh *mesh = assimpMeshRef->mAiMesh;
-
-                vertices = assimpMeshRef->mCachedTriMesh->getPositions<3>();
-                for (int v = 0; v < numVertices; ++v) {
-                    vertices[v] = fromAssimp(mesh->mVertices[v]);
-				}
-
-				std::vector<ci::vec3>& normals = assimpMeshRef->mCachedTriMesh->getNormals();
-				for( size_t v = 0; v < normals.size(); ++v )
-					normals[v] = fromAssimp( mesh->mNormals[ v ] );
-			}
+			assimpMeshRef->mAnimatedBounds = assimpMeshRef->mBindBounds;
+			assimpMeshRef->mGpuDirty = true;
 
 			assimpMeshRef->mValidCache = true;
 		}
@@ -866,20 +1893,103 @@ void AssimpLoader::enableSkinning( bool enable /* = true */ )
 	}
 }
 
+void AssimpLoader::enableSparseSkinning( bool enable /* = true */ )
+{
+	mSparseSkinningEnabled = enable;
+	if ( !enable )
+		return;
+
+	for ( const AssimpMeshRef& assimpMeshRef : mModelMeshes )
+	{
+		if ( assimpMeshRef->mBoneVertices.empty() && !assimpMeshRef->mBoneInfluences.empty() )
+			assimpMeshRef->mBoneVertices = buildBoneVertexLists( assimpMeshRef->mBoneInfluences, assimpMeshRef->mAiMesh->mNumBones );
+	}
+}
+
 void AssimpLoader::update()
 {
-	if ( mAnimationEnabled )
-		updateAnimation( mAnimationIndex, mAnimationTime );
+	// a paused animation or a repeated setTime() leaves the nodes where they are
+	bool sampled = false;
+	mPoseCacheEntry.reset();
+	const bool poseEdited = mAppliedPoseVersion != NotApplied && mHierarchy->getVersion() != mAppliedPoseVersion;
+	if ( poseEdited )
+		mCustomPose = true;
+	if ( mAnimationEnabled && ( poseEdited || mAppliedPoseVersion == NotApplied || mAnimationIndex != mAppliedAnimationIndex || mAnimationTime != mAppliedAnimationTime ) )
+	{
+		if ( mPoseCache && mScene->mNumAnimations > 0 )
+			sampled = !updateAnimationFromCache();
+		else
+			updateAnimation( mAnimationIndex, mAnimationTime );
+		mAppliedPoseVersion = mHierarchy->getVersion();
+		mAppliedAnimationIndex = mAnimationIndex;
+		mAppliedAnimationTime = mAnimationTime;
+	}
+
+	updateMorphTargets();
 
 	if ( mSkinningEnabled )
 		updateSkinning();
 
 	updateMeshes();
+	updateAnimatedBounds();
+
+	// share what this loader sampled, including the palette it produced
+	if ( sampled )
+	{
+		auto entry = std::make_shared< PoseCache::Entry >();
+		entry->mChannelPoses = mChannelPoses;
+		if ( mSkinningEnabled && !mCustomPose )
+			entry->mPalette = mSkeletonPalette;
+		mPoseCache->insert( mPoseCache->getKey( mPoseCacheModel, mAnimationIndex, mAnimationTime ), entry );
+	}
+}
+
+bool AssimpLoader::updateAnimationFromCache()
+{
+	// every loader samples the quantized time, so an entry is the same whoever made it
+	PoseCache::Key key = mPoseCache->getKey( mPoseCacheModel, mAnimationIndex, mAnimationTime );
+	double sampleTime = mPoseCache->getSampleTime( key );
+
+	mPoseCacheEntry = mPoseCache->find( key );
+	if ( mPoseCacheEntry )
+		applyChannelPoses( mAnimationIndex, mPoseCacheEntry->mChannelPoses );
+	else
+	{
+		sampleAnimation( mAnimationIndex, sampleTime, mChannelPoses );
+		applyChannelPoses( mAnimationIndex, mChannelPoses );
+	}
+	updateMorphAnimation( mAnimationIndex, sampleTime );
+
+	return mPoseCacheEntry != nullptr;
+}
+
+void AssimpLoader::setPoseCache( PoseCacheRef cache, const std::string &modelKey /* = "" */ )
+{
+	mPoseCache = cache;
+	if ( mPoseCache )
+		mPoseCacheModel = mPoseCache->getModelId( modelKey.empty() ? mFilePath.string() : modelKey );
+	mAppliedPoseVersion = NotApplied;
+}
+
+void AssimpLoader::updateAnimatedBounds()
+{
+	if ( mModelMeshes.empty() )
+		return;
+
+	vec3 boundsMin( std::numeric_limits< float >::max() );
+	vec3 boundsMax( -std::numeric_limits< float >::max() );
+	for ( const AssimpMeshRef &assimpMeshRef : mModelMeshes )
+	{
+		boundsMin = glm::min( boundsMin, assimpMeshRef->mAnimatedBounds.getMin() );
+		boundsMax = glm::max( boundsMax, assimpMeshRef->mAnimatedBounds.getMax() );
+	}
+	mAnimatedBoundingBox = AxisAlignedBox( boundsMin, boundsMax );
 }
 
 bool AssimpLoader::drawMesh(int index) {
     if (index < getNumMeshes()) {
         drawMesh(mModelMeshes[index]);
+        return true;
 	}
 	else {
         CI_LOG_W("Index " << index << " exceeds the number of meshes in model; could not render mesh.");
@@ -898,24 +2008,326 @@ bool AssimpLoader::drawMesh(const std::string& name) {
 	}
 }
 
-void AssimpLoader::draw() {
-    glPushAttrib(GL_ALL_ATTRIB_BITS);
-    glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
-    gl::enable(GL_NORMALIZE);
+void AssimpLoader::updateGpu() {
+    if (!mGpuResourcesEnabled)
+        return;
+
+    // only meshes a node draws; batched meshes no node references never get vertex buffers
+    for (const AssimpNodeRef& nodeRef : mMeshNodes) {
+        for (const AssimpMeshRef& assimpMeshRef : nodeRef->getMeshes()) {
+            uploadMesh(assimpMeshRef.get());
+        }
+    }
+}
 
+void AssimpLoader::uploadMesh(AssimpMesh* assimpMesh) {
+    if (!assimpMesh->mVboMesh && assimpMesh->mStreamVboMeshes.empty()) {
+        // every VboMesh carries the instance attributes, so drawInstanced() never has to rebuild a batch
+        if (!mInstanceMatrixVbo) {
+            createInstanceBuffers();
+        }
+        createVboMesh(assimpMesh);
+        appendInstanceBuffers(assimpMesh);
+        return;
+    }
+    if (!assimpMesh->mGpuDirty)
+        return;
+
+    // only positions and normals change; everything else was uploaded at load
+    if (assimpMesh->mVertexStream) {
+        mUploadBytes += streamVertices(assimpMesh);
+    } else if (assimpMesh->mVboMesh) {
+        const std::vector<float>& positions = assimpMesh->mCachedTriMesh->getBufferPositions();
+        assimpMesh->mPositionVbo->bufferSubData(0, positions.size() * sizeof(float), positions.data());
+        mUploadBytes += positions.size() * sizeof(float);
+        const std::vector<float>& normals = assimpMesh->mCachedTriMesh->getBufferNormals();
+        if (assimpMesh->mNormalVbo && !normals.empty()) {
+            assimpMesh->mNormalVbo->bufferSubData(0, normals.size() * sizeof(float), normals.data());
+            mUploadBytes += normals.size() * sizeof(float);
+        }
+    }
+    assimpMesh->mGpuDirty = false;
+}
+
+gl::BatchRef AssimpLoader::getBatch(AssimpMesh* assimpMesh, const gl::GlslProgRef& shader) {
+    // streamed meshes draw the VboMesh of the region written last
+    const bool streamed = assimpMesh->mVertexStream != nullptr;
+    const size_t index = streamed ? assimpMesh->mVertexStream->getRegion() : 0;
+
+    // batches of replaced shaders are dropped by pruneBatches() when the queues are rebuilt
+    std::vector<gl::BatchRef>& batches = assimpMesh->mBatches[shader];
+    batches.resize(streamed ? assimpMesh->mStreamVboMeshes.size() : 1);
+    if (!batches[index]) {
+        // the instance attributes are only read by instanced shaders; others ignore them
+        const gl::Batch::AttributeMapping instanceAttributes = {{geom::Attrib::CUSTOM_0, "iModelMatrix"},
+                                                                {geom::Attrib::CUSTOM_1, "iTint"}};
+        batches[index] = gl::Batch::create(streamed ? assimpMesh->mStreamVboMeshes[index] : assimpMesh->mVboMesh, shader,
+                                           instanceAttributes);
+    }
+    return batches[index];
+}
+
+void AssimpLoader::pruneBatches() {
+    // the references the loader's own caches and queues hold; a shader nobody else holds anymore,
+    // e.g. a replaced custom or phong shader, is never drawn with again
+    std::vector<AssimpMeshRef> meshes = mModelMeshes;
+    meshes.insert(meshes.end(), mBatchedMeshes.begin(), mBatchedMeshes.end());
+    std::unordered_map<const gl::GlslProg*, long> loaderRefs;
+    for (const AssimpMeshRef& assimpMeshRef : meshes) {
+        for (const auto& entry : assimpMeshRef->mBatches) {
+            loaderRefs[entry.first.get()] += 1 + std::count_if(entry.second.begin(), entry.second.end(),
+                                                               [](const gl::BatchRef& batch) { return batch != nullptr; });
+        }
+    }
+    for (const RenderQueueRef& queue : {mRenderQueue, mInstancedQueue}) {
+        for (const RenderItem& item : queue->getItems()) {
+            ++loaderRefs[item.mShader.get()];
+        }
+    }
+
+    for (const AssimpMeshRef& assimpMeshRef : meshes) {
+        std::unordered_map<gl::GlslProgRef, std::vector<gl::BatchRef>>& batches = assimpMeshRef->mBatches;
+        for (auto it = batches.begin(); it != batches.end();) {
+            it = it->first.use_count() <= loaderRefs[it->first.get()] ? batches.erase(it) : std::next(it);
+        }
+    }
+}
+
+size_t AssimpLoader::getNumCachedBatches() const {
+    size_t numBatches = 0;
+    std::vector<AssimpMeshRef> meshes = mModelMeshes;
+    meshes.insert(meshes.end(), mBatchedMeshes.begin(), mBatchedMeshes.end());
+    for (const AssimpMeshRef& assimpMeshRef : meshes) {
+        for (const auto& entry : assimpMeshRef->mBatches) {
+            numBatches += std::count_if(entry.second.begin(), entry.second.end(), [](const gl::BatchRef& batch) { return batch != nullptr; });
+        }
+    }
+    return numBatches;
+}
+
+void AssimpLoader::buildRenderQueue(const RenderQueueRef& queue, bool instanced, bool tinted) {
+    queue->clear();
+    pruneBatches();
     for (auto it = mMeshNodes.begin(); it != mMeshNodes.end(); ++it) {
-		AssimpNodeRef nodeRef = *it;
-        
-        //ci::gl::pushMatrices();
-        //ci::gl::setModelMatrix((*it)->getDerivedTransform());
+        AssimpNodeRef nodeRef = *it;
+        for (auto meshIt = nodeRef->getMeshes().begin(); meshIt != nodeRef->getMeshes().end(); ++meshIt) {
+            if (!instanced && (*meshIt)->mStaticMerged && isStaticMergingActive())
+                continue;
+            RenderItem item = makeRenderItem(*meshIt, instanced, tinted);
+            item.mNode = getPlacingNode(*nodeRef, meshIt->get());
+            queue->push(item);
+        }
+    }
+    queue->sort();
+}
 
-		for (auto meshIt = nodeRef->getMeshes().begin(); meshIt != nodeRef->getMeshes().end(); ++meshIt) {
-			AssimpMeshRef assimpMeshRef = *meshIt;
-            drawMesh(assimpMeshRef);
+void AssimpLoader::draw() {
+    // before the arena and the queue, which may have to pick up other shaders
+    updateMaterialBuffer();
+
+    RenderQueue::Stats arenaStats;
+    if (isStaticMergingActive()) {
+        if (!mStaticArena) {
+            buildStaticArena();
         }
+        drawStaticArena(arenaStats);
+    }
 
-        //ci::gl::popMatrices();
-	}
-    glPopClientAttrib();
-	glPopAttrib();
+    // sort keys only change with the draw settings, so the queue is built once and reused
+    if (mRenderQueueDirty) {
+        buildRenderQueue(mRenderQueue, false, false);
+        mRenderQueueDirty = false;
+    }
+
+    const std::vector<RenderItem>& items = mRenderQueue->getItems();
+    submitRenderItems(items.data(), items.size());
+
+    mRenderStats.mNumDraws += arenaStats.mNumDraws;
+    mRenderStats.mNumProgramChanges += arenaStats.mNumProgramChanges;
+    mRenderStats.mNumTextureChanges += arenaStats.mNumTextureChanges;
+    mRenderStats.mNumCullChanges += arenaStats.mNumCullChanges;
+    mRenderStats.mNumMaterialChanges += arenaStats.mNumMaterialChanges;
+}
+
+bool AssimpLoader::isStaticMergingActive() const {
+    return mStaticMergingEnabled && !(mCustomShaderEnabled && mCustomShaderProgram != nullptr);
+}
+
+void AssimpLoader::buildStaticArena() {
+    mStaticArena = StaticArena::create();
+    for (const AssimpNodeRef& nodeRef : mMeshNodes) {
+        for (const AssimpMeshRef& assimpMeshRef : nodeRef->getMeshes()) {
+            // skinned and morphed vertices change every frame, and their streams may not exist before
+            // the first upload; meshes with a shader of their own keep it
+            const bool dynamic = assimpMeshRef->mAiMesh->HasBones() || !assimpMeshRef->mMorphTargets.empty();
+            assimpMeshRef->mStaticMerged = !dynamic && !assimpMeshRef->mShader;
+            if (assimpMeshRef->mStaticMerged) {
+                mStaticArena->add(assimpMeshRef.get(), getPlacingNode(*nodeRef, assimpMeshRef.get()));
+            }
+        }
+    }
+    if (!mStaticArena->empty()) {
+        mStaticArena->build();
+    }
+
+    if (mStaticArena->isMultiDrawIndirect() && !mArenaShaderProgram) {
+        auto vertexShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/vertex/arena.vert"));
+        auto fragmentShader = ci::app::loadAsset(ci::app::getAssetPath("glsl/frag/arena.frag"));
+        mArenaShaderProgram = ci::gl::GlslProg::create(vertexShader, fragmentShader);
+    }
+    mRenderQueueDirty = true;
+}
+
+void AssimpLoader::drawStaticArena(RenderQueue::Stats& stats) {
+    if (mStaticArena->empty())
+        return;
+
+    mStaticArena->updateTransforms(*mHierarchy);
+    mStaticArena->updateCommands(mTexturesEnabled);
+    const std::vector<StaticArena::Group>& groups = mStaticArena->getGroups();
+    const std::vector<StaticArena::DrawCommand>& commands = mStaticArena->getCommands();
+    if (commands.empty())
+        return;
+
+    gl::ScopedState cullState(GL_CULL_FACE, false);
+    bool cullFace = false;
+    auto setCullFace = [&](bool enable) {
+        if (enable != cullFace) {
+            if (enable) {
+                gl::enable(GL_CULL_FACE);
+            } else {
+                gl::disable(GL_CULL_FACE);
+            }
+            cullFace = enable;
+            ++stats.mNumCullChanges;
+        }
+    };
+
+#if !defined(CINDER_GL_ES)
+    if (mStaticArena->isMultiDrawIndirect()) {
+        // one call per group; the shader finds transform and material through the base instance
+        gl::BatchRef batch = mStaticArena->getBatch(mArenaShaderProgram);
+        gl::ScopedGlslProg scopedShader(mArenaShaderProgram);
+        gl::ScopedVao scopedVao(batch->getVao());
+        gl::ScopedBuffer scopedCommands(mStaticArena->getCommandBuffer());
+        gl::setDefaultShaderVars();
+        mStaticArena->bindBuffers();
+        mArenaShaderProgram->uniform("uMaterials", mMaterialsEnabled);
+        mArenaShaderProgram->uniform("uTexture", 0);
+        ++stats.mNumProgramChanges;
+
+        for (const StaticArena::Group& group : groups) {
+            setCullFace(group.mCullFace);
+            if (group.mTexture) {
+                group.mTexture->bind();
+                ++stats.mNumTextureChanges;
+            }
+            mArenaShaderProgram->uniform("uTextured", group.mTexture != nullptr);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                        reinterpret_cast<const void*>(group.mFirstCommand * sizeof(StaticArena::DrawCommand)),
+                                        static_cast<GLsizei>(group.mNumCommands), 0);
+            ++stats.mNumDraws;
+            if (group.mTexture) {
+                group.mTexture->unbind();
+            }
+        }
+        return;
+    }
+#endif
+
+    // fallback: one draw per command from the same buffers, with the regular shaders
+    if (mMaterialUbo) {
+        mMaterialUbo->bindBufferBase(MaterialBufferBinding);
+    }
+    for (const StaticArena::Group& group : groups) {
+        setCullFace(group.mCullFace);
+
+        ci::gl::ShaderDef shaderDef = ci::gl::ShaderDef().lambert().color();
+        if (group.mTexture) {
+            shaderDef.texture();
+            group.mTexture->bind();
+            ++stats.mNumTextureChanges;
+        }
+        gl::GlslProgRef shader = mMaterialsEnabled ? mPhongShaderProgram : ci::gl::getStockShader(shaderDef);
+        gl::BatchRef batch = mStaticArena->getBatch(shader);
+        gl::ScopedGlslProg scopedShader(shader);
+        gl::ScopedVao scopedVao(batch->getVao());
+        ++stats.mNumProgramChanges;
+
+        int64_t material = -1;
+        for (size_t c = group.mFirstCommand; c < group.mFirstCommand + group.mNumCommands; ++c) {
+            const StaticArena::DrawCommand& command = commands[c];
+            const StaticArena::Draw& draw = mStaticArena->getDraw(command.mBaseInstance);
+            if (mMaterialsEnabled && draw.mMaterial != material) {
+                applyMaterial(shader, draw.mMesh);
+                material = draw.mMaterial;
+                ++stats.mNumMaterialChanges;
+            }
+
+            gl::ScopedModelMatrix scopedModelMatrix;
+            gl::multModelMatrix(mStaticArena->getTransform(command.mBaseInstance));
+            gl::setDefaultShaderVars();
+            glDrawElementsBaseVertex(GL_TRIANGLES, command.mCount, GL_UNSIGNED_INT,
+                                     reinterpret_cast<const void*>(command.mFirstIndex * sizeof(uint32_t)), command.mBaseVertex);
+            ++stats.mNumDraws;
+        }
+
+        if (group.mTexture) {
+            group.mTexture->unbind();
+        }
+    }
+}
+
+void AssimpLoader::createInstanceBuffers() {
+    mInstanceMatrixVbo = gl::Vbo::create(GL_ARRAY_BUFFER, sizeof(mat4), nullptr, GL_STREAM_DRAW);
+    mInstanceTintVbo = gl::Vbo::create(GL_ARRAY_BUFFER, sizeof(ColorAf), nullptr, GL_STREAM_DRAW);
+}
+
+void AssimpLoader::appendInstanceBuffers(AssimpMesh* assimpMesh) {
+    geom::BufferLayout matrixLayout;
+    matrixLayout.append(geom::Attrib::CUSTOM_0, 16, sizeof(mat4), 0, 1);
+    geom::BufferLayout tintLayout;
+    tintLayout.append(geom::Attrib::CUSTOM_1, 4, sizeof(ColorAf), 0, 1);
+
+    // every VboMesh reads the same instance buffers
+    std::vector<gl::VboMeshRef> vboMeshes = assimpMesh->mStreamVboMeshes;
+    if (assimpMesh->mVboMesh) {
+        vboMeshes.push_back(assimpMesh->mVboMesh);
+    }
+    for (const gl::VboMeshRef& vboMesh : vboMeshes) {
+        vboMesh->appendVbo(matrixLayout, mInstanceMatrixVbo);
+        vboMesh->appendVbo(tintLayout, mInstanceTintVbo);
+    }
+}
+
+void AssimpLoader::drawInstanced(const std::vector<ci::mat4>& transforms, const std::vector<ci::ColorAf>& tints) {
+    if (transforms.empty()) {
+        return;
+    }
+    if (!tints.empty() && tints.size() != transforms.size()) {
+        CI_LOG_E("drawInstanced() needs one tint per transform; got " << tints.size() << " tints for " << transforms.size() << " transforms");
+        return;
+    }
+
+    updateMaterialBuffer();
+    if (!mInstanceMatrixVbo) {
+        createInstanceBuffers();
+    }
+    // orphan and refill, so the upload never waits on draws of the previous frame
+    mInstanceMatrixVbo->bufferData(transforms.size() * sizeof(mat4), transforms.data(), GL_STREAM_DRAW);
+    mUploadBytes += transforms.size() * sizeof(mat4);
+    const bool tinted = !tints.empty();
+    if (tinted) {
+        mInstanceTintVbo->bufferData(tints.size() * sizeof(ColorAf), tints.data(), GL_STREAM_DRAW);
+        mUploadBytes += tints.size() * sizeof(ColorAf);
+    }
+
+    if (mInstancedQueueDirty || mInstancedQueueTinted != tinted) {
+        buildRenderQueue(mInstancedQueue, true, tinted);
+        mInstancedQueueDirty = false;
+        mInstancedQueueTinted = tinted;
+    }
+
+    const std::vector<RenderItem>& items = mInstancedQueue->getItems();
+    submitRenderItems(items.data(), items.size(), static_cast<GLsizei>(transforms.size()));
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "Morphing.h"
+#include "Skinning.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SITARA_ASSIMP_MORPHING_X86
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace sitara::assimp;
+
+namespace {
+    bool isDisplaced(const aiVector3D& delta) {
+        return delta.x != 0.0f || delta.y != 0.0f || delta.z != 0.0f;
+    }
+
+    void pushDelta(std::vector<float>& deltas, const aiVector3D& delta) {
+        deltas.push_back(delta.x);
+        deltas.push_back(delta.y);
+        deltas.push_back(delta.z);
+        deltas.push_back(0.0f);
+    }
+
+    void applyScalar(const uint32_t* vertices, size_t count, const float* deltas, float weight, float* dst) {
+        for (size_t i = 0; i < count; ++i) {
+            float* v = dst + vertices[i] * 3;
+            const float* d = deltas + i * 4;
+            v[0] += weight * d[0];
+            v[1] += weight * d[1];
+            v[2] += weight * d[2];
+        }
+    }
+
+#ifdef SITARA_ASSIMP_MORPHING_X86
+    void applySse(const uint32_t* vertices, size_t count, const float* deltas, float weight, float* dst) {
+        // the fourth lane of every delta is 0, so the unaligned four-float read-modify-write
+        // leaves the following float (the next vertex or the padding) unchanged
+        const __m128 w = _mm_set1_ps(weight);
+        for (size_t i = 0; i < count; ++i) {
+            float* v = dst + vertices[i] * 3;
+            __m128 d = _mm_loadu_ps(deltas + i * 4);
+            _mm_storeu_ps(v, _mm_add_ps(_mm_loadu_ps(v), _mm_mul_ps(w, d)));
+        }
+    }
+#endif
+
+    void apply(SkinningKernel kernel, const uint32_t* vertices, size_t count, const float* deltas, float weight,
+               float* dst) {
+#ifdef SITARA_ASSIMP_MORPHING_X86
+        if (kernel != SkinningKernel::Scalar) {
+            applySse(vertices, count, deltas, weight, dst);
+            return;
+        }
+#endif
+        applyScalar(vertices, count, deltas, weight, dst);
+    }
+}
+
+MorphTarget sitara::assimp::buildMorphTarget(const aiMesh* mesh, const aiAnimMesh* animMesh) {
+    MorphTarget target;
+    target.mName = animMesh->mName.C_Str();
+
+    const bool hasPositions = animMesh->HasPositions();
+    const bool hasNormals = animMesh->HasNormals() && mesh->HasNormals();
+    const unsigned numVertices = std::min(mesh->mNumVertices, animMesh->mNumVertices);
+
+    for (unsigned v = 0; v < numVertices; ++v) {
+        const aiVector3D position = hasPositions ? animMesh->mVertices[v] - mesh->mVertices[v] : aiVector3D(0, 0, 0);
+        const aiVector3D normal = hasNormals ? animMesh->mNormals[v] - mesh->mNormals[v] : aiVector3D(0, 0, 0);
+        if (!isDisplaced(position) && !isDisplaced(normal)) {
+            continue;
+        }
+
+        target.mVertices.push_back(v);
+        pushDelta(target.mPositionDeltas, position);
+        if (hasNormals) {
+            pushDelta(target.mNormalDeltas, normal);
+        }
+    }
+
+    return target;
+}
+
+void sitara::assimp::applyMorphTarget(const MorphTarget& target, float weight, float* positions, float* normals) {
+    applyMorphTarget(getSkinningKernel(), target, weight, positions, normals);
+}
+
+void sitara::assimp::applyMorphTarget(SkinningKernel kernel, const MorphTarget& target, float weight,
+                                      float* positions, float* normals) {
+    if (weight == 0.0f || target.mVertices.empty()) {
+        return;
+    }
+
+    apply(kernel, target.mVertices.data(), target.mVertices.size(), target.mPositionDeltas.data(), weight, positions);
+    if (normals && !target.mNormalDeltas.empty()) {
+        apply(kernel, target.mVertices.data(), target.mVertices.size(), target.mNormalDeltas.data(), weight, normals);
+    }
+}
@@ -21,223 +21,140 @@ using namespace ci;
 using namespace std;
 using namespace sitara::assimp;
 
-AssimpNode::AssimpNode() :
-	mScale( vec3(1) ),
-	mInheritOrientation( true ),
-	mInheritScale( true ),
-	mNeedsUpdate( true )
+AssimpNode::AssimpNode( NodeHierarchyRef hierarchy, size_t index ) :
+	mHierarchy( hierarchy ),
+	mIndex( index )
 {
 }
 
-AssimpNode::AssimpNode( const std::string &name ) :
-	mName( name ),
-	mScale( vec3(1) ),
-	mInheritOrientation( true ),
-	mInheritScale( true ),
-	mNeedsUpdate( true )
-{
-}
-
-void AssimpNode::setParent( AssimpNodeRef parent )
+AssimpNodeRef AssimpNode::getParent() const
 {
-	mParent = parent;
-	requestUpdate();
+	int parent = mHierarchy->getParent( mIndex );
+	if ( parent < 0 )
+		return AssimpNodeRef();
+	return AssimpNodeRef( new AssimpNode( mHierarchy, parent ) );
 }
 
-AssimpNodeRef AssimpNode::getParent() const
+NodeHierarchyRef AssimpNode::getHierarchy() const
 {
-	return mParent;
+	return mHierarchy;
 }
 
-void AssimpNode::addChild( AssimpNodeRef child )
+size_t AssimpNode::getIndex() const
 {
-	mChildren.push_back( child );
+	return mIndex;
 }
 
 void AssimpNode::setOrientation( const ci::quat &q )
 {
-	mOrientation = q;
-	mOrientation = glm::normalize(mOrientation);
-	requestUpdate();
+	mHierarchy->setOrientation( mIndex, q );
 }
 
 const quat &AssimpNode::getOrientation() const
 {
-	return mOrientation;
+	return mHierarchy->getOrientation( mIndex );
 }
 
 void AssimpNode::setPosition( const ci::vec3 &pos )
 {
-	mPosition = pos;
-	requestUpdate();
+	mHierarchy->setPosition( mIndex, pos );
 }
 
 const vec3& AssimpNode::getPosition() const
 {
-	return mPosition;
+	return mHierarchy->getPosition( mIndex );
 }
 
 void AssimpNode::setScale( const vec3 &scale )
 {
-	mScale = scale;
-	requestUpdate();
+	mHierarchy->setScale( mIndex, scale );
 }
 
 const vec3 &AssimpNode::getScale() const
 {
-	return mScale;
+	return mHierarchy->getScale( mIndex );
 }
 
 void AssimpNode::setInheritOrientation( bool inherit )
 {
-	mInheritOrientation = inherit;
-	requestUpdate();
+	mHierarchy->setInheritOrientation( mIndex, inherit );
 }
 
 bool AssimpNode::getInheritOrientation() const
 {
-	return mInheritOrientation;
+	return mHierarchy->getInheritOrientation( mIndex );
 }
 
 void AssimpNode::setInheritScale( bool inherit )
 {
-	mInheritScale = inherit;
-	requestUpdate();
+	mHierarchy->setInheritScale( mIndex, inherit );
 }
 
 bool AssimpNode::getInheritScale() const
 {
-	return mInheritScale;
+	return mHierarchy->getInheritScale( mIndex );
 }
 
 void AssimpNode::setName( const string &name )
 {
-	mName = name;
+	mHierarchy->setName( mIndex, name );
 }
 
 const string &AssimpNode::getName() const
 {
-	return mName;
+	return mHierarchy->getName( mIndex );
 }
 
 void AssimpNode::setInitialState()
 {
-	mInitialPosition = mPosition;
-	mInitialOrientation = mOrientation;
-	mInitialScale = mScale;
+	mHierarchy->setInitialState( mIndex );
 }
 
 void AssimpNode::resetToInitialState()
 {
-	mPosition = mInitialPosition;
-	mOrientation = mInitialOrientation;
-	mScale = mInitialScale;
-	requestUpdate();
+	mHierarchy->resetToInitialState( mIndex );
 }
 
 const vec3 &AssimpNode::getInitialPosition() const
 {
-	return mInitialPosition;
+	return mHierarchy->getInitialPose( mIndex ).mPosition;
 }
 
 const quat &AssimpNode::getInitialOrientation() const
 {
-	return mInitialOrientation;
+	return mHierarchy->getInitialPose( mIndex ).mOrientation;
 }
 
 const vec3 &AssimpNode::getInitialScale() const
 {
-	return mInitialScale;
+	return mHierarchy->getInitialPose( mIndex ).mScale;
 }
 
 const quat &AssimpNode::getDerivedOrientation() const
 {
-	if ( mNeedsUpdate )
-		update();
-	return mDerivedOrientation;
+	return mHierarchy->getDerivedOrientation( mIndex );
 }
 
 const vec3 &AssimpNode::getDerivedPosition() const
 {
-	if ( mNeedsUpdate )
-		update();
-	return mDerivedPosition;
+	return mHierarchy->getDerivedPosition( mIndex );
 }
 
 const vec3 &AssimpNode::getDerivedScale() const
 {
-	if ( mNeedsUpdate )
-		update();
-	return mDerivedScale;
+	return mHierarchy->getDerivedScale( mIndex );
 }
 
 const mat4 &AssimpNode::getDerivedTransform() const
 {
-	if ( mNeedsUpdate )
-		update();
-
-    mDerivedTransform = glm::scale(mDerivedScale);
-    mDerivedTransform *= ci::mat4(mDerivedOrientation);
-    mDerivedTransform *= glm::translate(mDerivedPosition);
-
-    return mDerivedTransform;
+	return mHierarchy->getDerivedTransform( mIndex );
 }
 
 std::vector<AssimpMeshRef>& AssimpNode::getMeshes() {
-    return mMeshes;
-}
-
-void AssimpNode::update() const
-{
-    if ( mParent )
-    {
-        // update orientation
-        const quat &parentOrientation = mParent->getDerivedOrientation();
-        if ( mInheritOrientation )
-        {
-            // Combine orientation with that of parent
-            mDerivedOrientation = getOrientation() * parentOrientation;
-        }
-        else
-        {
-            mDerivedOrientation = getOrientation();
-        }
-
-        // update scale
-        const vec3 &parentScale = mParent->getDerivedScale();
-        if ( mInheritScale )
-        {
-            mDerivedScale = parentScale * getScale();
-        }
-        else
-        {
-            mDerivedScale = getScale();
-        }
-
-		// change position vector based on parent's orientation & scale
-        mDerivedPosition = ( parentScale * getPosition() ) * parentOrientation;
-
-        // add altered position vector to parent's
-        mDerivedPosition += mParent->getDerivedPosition();
-    }
-    else
-    {
-        // root AssimpNode, no parent
-        mDerivedOrientation = getOrientation();
-        mDerivedPosition = getPosition();
-        mDerivedScale = getScale();
-    }
-
-	mNeedsUpdate = false;
+	return mHierarchy->getMeshes( mIndex );
 }
 
 void AssimpNode::requestUpdate()
 {
-	mNeedsUpdate = true;
-
-	for ( vector< AssimpNodeRef >::iterator it = mChildren.begin();
-			it != mChildren.end(); ++it )
-	{
-		(*it)->requestUpdate();
-	}
-}
\ No newline at end of file
+	mHierarchy->invalidate( mIndex );
+}
@@ -0,0 +1,209 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <assert.h>
+
+#include "NodeHierarchy.h"
+
+using namespace ci;
+using namespace std;
+using namespace sitara::assimp;
+
+NodeHierarchyRef NodeHierarchy::create() {
+    return NodeHierarchyRef(new NodeHierarchy());
+}
+
+NodeHierarchy::NodeHierarchy() : mFirstDirty(0), mVersion(0) {}
+
+size_t NodeHierarchy::addNode(const std::string& name, int parent) {
+    size_t index = mParents.size();
+    assert(parent < static_cast<int>(index));
+
+    // the name table views the strings in mNames; growing the vector moves them
+    bool reallocates = mNames.size() == mNames.capacity();
+    mParents.push_back(parent);
+    mNames.push_back(name);
+    if (reallocates) {
+        rebuildNameIndex();
+    } else {
+        mNameIndex[mNames.back()] = static_cast<NodeHandle>(index);
+    }
+    mLocalPoses.push_back(NodePose());
+    mInitialPoses.push_back(NodePose());
+    mInheritOrientation.push_back(1);
+    mInheritScale.push_back(1);
+    mMeshes.push_back(std::vector<AssimpMeshRef>());
+
+    mDerivedPoses.push_back(NodePose());
+    mDerivedTransforms.push_back(mat4(1));
+    mDirty.push_back(1);
+    mFirstDirty = std::min(mFirstDirty, index);
+
+    return index;
+}
+
+void NodeHierarchy::setName(size_t i, const std::string& name) {
+    // with duplicate names a key may view the old name of node i while mapping another node;
+    // renames are rare, so the table is rebuilt from mNames instead of patched
+    mNames[i] = name;
+    rebuildNameIndex();
+}
+
+NodeHandle NodeHierarchy::findNode(const std::string_view& name) const {
+    auto it = mNameIndex.find(name);
+    if (it != mNameIndex.end()) {
+        return it->second;
+    }
+    return InvalidNodeHandle;
+}
+
+void NodeHierarchy::reserve(size_t numNodes) {
+    mParents.reserve(numNodes);
+    mNames.reserve(numNodes);
+    mLocalPoses.reserve(numNodes);
+    mInitialPoses.reserve(numNodes);
+    mInheritOrientation.reserve(numNodes);
+    mInheritScale.reserve(numNodes);
+    mMeshes.reserve(numNodes);
+    mDerivedPoses.reserve(numNodes);
+    mDerivedTransforms.reserve(numNodes);
+    mDirty.reserve(numNodes);
+    rebuildNameIndex();
+    mNameIndex.reserve(numNodes);
+}
+
+void NodeHierarchy::rebuildNameIndex() {
+    mNameIndex.clear();
+    for (size_t i = 0; i < mNames.size(); ++i) {
+        mNameIndex[mNames[i]] = static_cast<NodeHandle>(i);
+    }
+}
+
+void NodeHierarchy::setOrientation(size_t i, const ci::quat& q) {
+    mLocalPoses[i].mOrientation = glm::normalize(q);
+    invalidate(i);
+}
+
+void NodeHierarchy::setPosition(size_t i, const ci::vec3& pos) {
+    mLocalPoses[i].mPosition = pos;
+    invalidate(i);
+}
+
+void NodeHierarchy::setScale(size_t i, const ci::vec3& scale) {
+    mLocalPoses[i].mScale = scale;
+    invalidate(i);
+}
+
+void NodeHierarchy::setLocalPose(size_t i, const NodePose& pose) {
+    mLocalPoses[i].mPosition = pose.mPosition;
+    mLocalPoses[i].mOrientation = glm::normalize(pose.mOrientation);
+    mLocalPoses[i].mScale = pose.mScale;
+    invalidate(i);
+}
+
+void NodeHierarchy::commitPose() {
+    ++mVersion;
+    std::fill(mDirty.begin(), mDirty.end(), 1);
+    mFirstDirty = 0;
+    update();
+}
+
+void NodeHierarchy::setInheritOrientation(size_t i, bool inherit) {
+    mInheritOrientation[i] = inherit;
+    invalidate(i);
+}
+
+void NodeHierarchy::setInheritScale(size_t i, bool inherit) {
+    mInheritScale[i] = inherit;
+    invalidate(i);
+}
+
+void NodeHierarchy::resetToInitialState(size_t i) {
+    mLocalPoses[i] = mInitialPoses[i];
+    invalidate(i);
+}
+
+const quat& NodeHierarchy::getDerivedOrientation(size_t i) const {
+    update();
+    return mDerivedPoses[i].mOrientation;
+}
+
+const vec3& NodeHierarchy::getDerivedPosition(size_t i) const {
+    update();
+    return mDerivedPoses[i].mPosition;
+}
+
+const vec3& NodeHierarchy::getDerivedScale(size_t i) const {
+    update();
+    return mDerivedPoses[i].mScale;
+}
+
+const mat4& NodeHierarchy::getDerivedTransform(size_t i) const {
+    update();
+    return mDerivedTransforms[i];
+}
+
+void NodeHierarchy::invalidate(size_t i) {
+    ++mVersion;
+    mDirty[i] = 1;
+    mFirstDirty = std::min(mFirstDirty, i);
+}
+
+void NodeHierarchy::update() const {
+    const size_t numNodes = mParents.size();
+    if (mFirstDirty >= numNodes) {
+        return;
+    }
+
+    // parents precede their children, so a single forward pass sees every parent's derived
+    // pose (and dirty flag) before it is needed
+    for (size_t i = mFirstDirty; i < numNodes; ++i) {
+        const int parent = mParents[i];
+        if (parent >= 0 && mDirty[parent]) {
+            mDirty[i] = 1;
+        }
+        if (!mDirty[i]) {
+            continue;
+        }
+
+        const NodePose& local = mLocalPoses[i];
+        NodePose& derived = mDerivedPoses[i];
+        if (parent >= 0) {
+            const NodePose& parentPose = mDerivedPoses[parent];
+
+            // combine orientation and scale with those of the parent
+            derived.mOrientation = mInheritOrientation[i] ? local.mOrientation * parentPose.mOrientation : local.mOrientation;
+            derived.mScale = mInheritScale[i] ? parentPose.mScale * local.mScale : local.mScale;
+
+            // change position vector based on parent's orientation & scale, then add it to the parent's
+            derived.mPosition = (parentPose.mScale * local.mPosition) * parentPose.mOrientation;
+            derived.mPosition += parentPose.mPosition;
+        } else {
+            // root node, no parent
+            derived = local;
+        }
+
+        mat4& transform = mDerivedTransforms[i];
+        transform = glm::scale(derived.mScale);
+        transform *= ci::mat4(derived.mOrientation);
+        transform *= glm::translate(derived.mPosition);
+    }
+
+    std::fill(mDirty.begin() + mFirstDirty, mDirty.end(), 0);
+    mFirstDirty = numNodes;
+}
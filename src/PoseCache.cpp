@@ -0,0 +1,126 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+
+#include "PoseCache.h"
+
+using namespace std;
+using namespace sitara::assimp;
+
+PoseCacheRef PoseCache::create(double timeQuantum, size_t capacity) {
+    return PoseCacheRef(new PoseCache(timeQuantum, capacity));
+}
+
+PoseCache::PoseCache(double timeQuantum, size_t capacity) : mTimeQuantum(timeQuantum), mCapacity(capacity) {}
+
+size_t PoseCache::KeyHash::operator()(const Key& key) const {
+    size_t h = std::hash<size_t>()(key.mModel);
+    h = h * 31 + std::hash<size_t>()(key.mAnimation);
+    h = h * 31 + std::hash<int64_t>()(key.mTimeStep);
+    return h;
+}
+
+size_t PoseCache::getModelId(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto inserted = mModelIds.emplace(model, mModelIds.size());
+    return inserted.first->second;
+}
+
+PoseCache::Key PoseCache::getKey(size_t model, size_t animation, double time) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Key key;
+    key.mModel = model;
+    key.mAnimation = animation;
+    key.mTimeStep = mTimeQuantum > 0.0 ? static_cast<int64_t>(std::llround(time / mTimeQuantum)) : 0;
+    return key;
+}
+
+PoseCache::EntryRef PoseCache::find(const Key& key) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mIndex.find(key);
+    if (it == mIndex.end()) {
+        ++mStats.mMisses;
+        return nullptr;
+    }
+
+    // move to the front of the recency list
+    mEntries.splice(mEntries.begin(), mEntries, it->second);
+    ++mStats.mHits;
+    return it->second->second;
+}
+
+void PoseCache::insert(const Key& key, EntryRef entry) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mCapacity == 0) {
+        return;
+    }
+
+    // another loader may have sampled the same key concurrently; either entry will do
+    auto it = mIndex.find(key);
+    if (it != mIndex.end()) {
+        it->second->second = entry;
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return;
+    }
+
+    mEntries.emplace_front(key, entry);
+    mIndex[key] = mEntries.begin();
+    evict();
+}
+
+void PoseCache::evict() {
+    while (mEntries.size() > mCapacity) {
+        mIndex.erase(mEntries.back().first);
+        mEntries.pop_back();
+        ++mStats.mEvictions;
+    }
+}
+
+void PoseCache::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+    mIndex.clear();
+}
+
+void PoseCache::setTimeQuantum(double seconds) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTimeQuantum = seconds;
+    mEntries.clear();
+    mIndex.clear();
+}
+
+void PoseCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCapacity = capacity;
+    evict();
+}
+
+size_t PoseCache::getSize() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+}
+
+PoseCache::Stats PoseCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void PoseCache::resetStats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = Stats();
+}
@@ -0,0 +1,71 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "RenderQueue.h"
+
+using namespace std;
+using namespace sitara::assimp;
+
+RenderQueueRef RenderQueue::create() {
+    return RenderQueueRef(new RenderQueue());
+}
+
+void RenderQueue::clear() {
+    mItems.clear();
+    mPrograms.clear();
+    mTextures.clear();
+    mMaterials.clear();
+}
+
+uint32_t RenderQueue::getId(std::vector<const void*>& ids, const void* object) {
+    auto it = std::find(ids.begin(), ids.end(), object);
+    if (it != ids.end()) {
+        return static_cast<uint32_t>(it - ids.begin());
+    }
+    ids.push_back(object);
+    return static_cast<uint32_t>(ids.size() - 1);
+}
+
+uint32_t RenderQueue::getMaterialId(const Material& material) {
+    for (size_t i = 0; i < mMaterials.size(); ++i) {
+        if (mMaterials[i].isSameShading(material)) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    mMaterials.push_back(material);
+    return static_cast<uint32_t>(mMaterials.size() - 1);
+}
+
+void RenderQueue::push(RenderItem item) {
+    // the most expensive change goes into the highest bits: program, then texture, culling and
+    // the material uniforms
+    const uint64_t program = getId(mPrograms, item.mShader.get()) & 0xffff;
+    const uint64_t texture = (item.mTexture ? getId(mTextures, item.mTexture.get()) + 1 : 0) & 0xffff;
+    const uint64_t cull = item.mCullFace ? 1 : 0;
+    item.mMaterial = getMaterialId(item.mMesh->mMaterial);
+    const uint64_t material = item.mMaterialUniforms ? item.mMaterial & 0x7fff : 0;
+
+    item.mKey = (program << 48) | (texture << 32) | (cull << 31) | (material << 16);
+    mItems.push_back(item);
+}
+
+void RenderQueue::sort() {
+    std::stable_sort(mItems.begin(), mItems.end(),
+                     [](const RenderItem& a, const RenderItem& b) { return a.mKey < b.mKey; });
+}
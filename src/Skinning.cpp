@@ -0,0 +1,383 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+
+#include "Skinning.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SITARA_ASSIMP_SKINNING_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SITARA_ASSIMP_TARGET_AVX
+#else
+#include <cpuid.h>
+#define SITARA_ASSIMP_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+using namespace std;
+using namespace sitara::assimp;
+
+static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "skinning kernels expect tightly packed vectors");
+
+BoneInfluences sitara::assimp::buildBoneInfluences(const aiMesh* mesh) {
+    BoneInfluences influences;
+    if (!mesh->HasBones()) {
+        return influences;
+    }
+
+    influences.mBones.assign(mesh->mNumVertices * MaxBoneInfluences, 0);
+    influences.mWeights.assign(mesh->mNumVertices * MaxBoneInfluences, 0.0f);
+
+    for (unsigned a = 0; a < mesh->mNumBones; ++a) {
+        const aiBone* bone = mesh->mBones[a];
+        for (unsigned b = 0; b < bone->mNumWeights; ++b) {
+            const aiVertexWeight& weight = bone->mWeights[b];
+            if (weight.mWeight <= 0.0f || weight.mVertexId >= mesh->mNumVertices) {
+                continue;
+            }
+
+            // insertion into the vertex's slots, which are kept sorted by decreasing weight; the
+            // weakest influence falls off the end
+            uint32_t* bones = &influences.mBones[weight.mVertexId * MaxBoneInfluences];
+            float* weights = &influences.mWeights[weight.mVertexId * MaxBoneInfluences];
+            size_t slot = MaxBoneInfluences;
+            while (slot > 0 && weights[slot - 1] < weight.mWeight) {
+                if (slot < MaxBoneInfluences) {
+                    bones[slot] = bones[slot - 1];
+                    weights[slot] = weights[slot - 1];
+                }
+                --slot;
+            }
+            if (slot < MaxBoneInfluences) {
+                bones[slot] = a;
+                weights[slot] = weight.mWeight;
+            }
+        }
+    }
+
+    // renormalize, dropped influences would otherwise shrink the vertex towards the origin
+    for (size_t v = 0; v < mesh->mNumVertices; ++v) {
+        float* weights = &influences.mWeights[v * MaxBoneInfluences];
+        float sum = 0.0f;
+        for (size_t i = 0; i < MaxBoneInfluences; ++i) {
+            sum += weights[i];
+        }
+        if (sum > 0.0f) {
+            for (size_t i = 0; i < MaxBoneInfluences; ++i) {
+                weights[i] /= sum;
+            }
+        }
+    }
+
+    return influences;
+}
+
+BoneVertexLists sitara::assimp::buildBoneVertexLists(const BoneInfluences& influences, size_t numBones) {
+    BoneVertexLists lists;
+    lists.mOffsets.assign(numBones + 1, 0);
+
+    // counting sort: count the vertices of every bone, turn the counts into offsets, then
+    // scatter the vertices in increasing order
+    const size_t numVertices = influences.getNumVertices();
+    for (size_t v = 0; v < numVertices; ++v) {
+        for (size_t i = 0; i < MaxBoneInfluences && influences.mWeights[v * MaxBoneInfluences + i] > 0.0f; ++i) {
+            ++lists.mOffsets[influences.mBones[v * MaxBoneInfluences + i] + 1];
+        }
+    }
+    for (size_t b = 0; b < numBones; ++b) {
+        lists.mOffsets[b + 1] += lists.mOffsets[b];
+    }
+
+    lists.mVertices.resize(lists.mOffsets[numBones]);
+    std::vector<uint32_t> next(lists.mOffsets.begin(), lists.mOffsets.end() - 1);
+    for (size_t v = 0; v < numVertices; ++v) {
+        for (size_t i = 0; i < MaxBoneInfluences && influences.mWeights[v * MaxBoneInfluences + i] > 0.0f; ++i) {
+            lists.mVertices[next[influences.mBones[v * MaxBoneInfluences + i]]++] = static_cast<uint32_t>(v);
+        }
+    }
+
+    return lists;
+}
+
+namespace {
+    typedef void (*SkinFn)(const uint32_t* bones, const float* weights, const aiMatrix4x4* boneMatrices,
+                           const float* srcPositions, const float* srcNormals, float* dstPositions, float* dstNormals,
+                           size_t first, size_t count);
+
+    void skinScalar(const uint32_t* bones, const float* weights, const aiMatrix4x4* boneMatrices,
+                    const float* srcPositions, const float* srcNormals, float* dstPositions, float* dstNormals,
+                    size_t first, size_t count) {
+        // one sequential pass: every vertex gathers its bones instead of every bone scattering
+        // into its vertices
+        for (size_t v = first; v < first + count; ++v) {
+            const aiVector3D srcPos(srcPositions[v * 3], srcPositions[v * 3 + 1], srcPositions[v * 3 + 2]);
+            aiVector3D position(0, 0, 0);
+            aiVector3D normal(0, 0, 0);
+            for (size_t i = 0; i < MaxBoneInfluences; ++i) {
+                const float weight = weights[v * MaxBoneInfluences + i];
+                if (weight == 0.0f) {
+                    break;
+                }
+                const aiMatrix4x4& posTrafo = boneMatrices[bones[v * MaxBoneInfluences + i]];
+                position += weight * (posTrafo * srcPos);
+                if (srcNormals) {
+                    // 3x3 matrix, contains the bone matrix without the
+                    // translation, only with rotation and possibly scaling
+                    const aiVector3D srcNorm(srcNormals[v * 3], srcNormals[v * 3 + 1], srcNormals[v * 3 + 2]);
+                    normal += weight * (aiMatrix3x3(posTrafo) * srcNorm);
+                }
+            }
+            dstPositions[v * 3] = position.x;
+            dstPositions[v * 3 + 1] = position.y;
+            dstPositions[v * 3 + 2] = position.z;
+            if (dstNormals) {
+                dstNormals[v * 3] = normal.x;
+                dstNormals[v * 3 + 1] = normal.y;
+                dstNormals[v * 3 + 2] = normal.z;
+            }
+        }
+    }
+
+#ifdef SITARA_ASSIMP_SKINNING_X86
+    inline void store3(float* dst, __m128 v) {
+        _mm_storel_pi(reinterpret_cast<__m64*>(dst), v);
+        _mm_store_ss(dst + 2, _mm_movehl_ps(v, v));
+    }
+
+    inline void skinVertexSse(const uint32_t* bones, const float* weights, const aiMatrix4x4* boneMatrices,
+                              const float* srcPosition, const float* srcNormal, float* dstPosition, float* dstNormal) {
+        // blend the top three rows of the bone matrices; aiMatrix4x4 is row major
+        __m128 r0 = _mm_setzero_ps();
+        __m128 r1 = _mm_setzero_ps();
+        __m128 r2 = _mm_setzero_ps();
+        __m128 r3 = _mm_setzero_ps();
+        for (size_t i = 0; i < MaxBoneInfluences && weights[i] != 0.0f; ++i) {
+            const float* m = &boneMatrices[bones[i]].a1;
+            const __m128 w = _mm_set1_ps(weights[i]);
+            r0 = _mm_add_ps(r0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+            r1 = _mm_add_ps(r1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+            r2 = _mm_add_ps(r2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+        }
+
+        // columns of the blended matrix, so the transform becomes three multiply-adds
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        __m128 p = _mm_add_ps(_mm_mul_ps(r0, _mm_set1_ps(srcPosition[0])), r3);
+        p = _mm_add_ps(p, _mm_mul_ps(r1, _mm_set1_ps(srcPosition[1])));
+        p = _mm_add_ps(p, _mm_mul_ps(r2, _mm_set1_ps(srcPosition[2])));
+        store3(dstPosition, p);
+
+        if (srcNormal && dstNormal) {
+            __m128 n = _mm_mul_ps(r0, _mm_set1_ps(srcNormal[0]));
+            n = _mm_add_ps(n, _mm_mul_ps(r1, _mm_set1_ps(srcNormal[1])));
+            n = _mm_add_ps(n, _mm_mul_ps(r2, _mm_set1_ps(srcNormal[2])));
+            store3(dstNormal, n);
+        }
+    }
+
+    void skinSse(const uint32_t* bones, const float* weights, const aiMatrix4x4* boneMatrices,
+                 const float* srcPositions, const float* srcNormals, float* dstPositions, float* dstNormals,
+                 size_t first, size_t count) {
+        for (size_t v = first; v < first + count; ++v) {
+            skinVertexSse(bones + v * MaxBoneInfluences, weights + v * MaxBoneInfluences, boneMatrices,
+                          srcPositions + v * 3, srcNormals ? srcNormals + v * 3 : nullptr,
+                          dstPositions + v * 3, dstNormals ? dstNormals + v * 3 : nullptr);
+        }
+    }
+
+    SITARA_ASSIMP_TARGET_AVX inline __m256 broadcastPair(float a, float b) {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(a)), _mm_set1_ps(b), 1);
+    }
+
+    SITARA_ASSIMP_TARGET_AVX inline __m256 loadPair(const float* a, const float* b) {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a)), _mm_loadu_ps(b), 1);
+    }
+
+    //! Top three rows of the zero matrix, blended in place of the bone of an unused slot.
+    const float ZeroRows[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    SITARA_ASSIMP_TARGET_AVX void skinAvx(const uint32_t* bones, const float* weights, const aiMatrix4x4* boneMatrices,
+                                          const float* srcPositions, const float* srcNormals, float* dstPositions,
+                                          float* dstNormals, size_t first, size_t count) {
+        // two vertices per iteration, one in each 128 bit lane
+        size_t v = first;
+        for (; v + 1 < first + count; v += 2) {
+            const uint32_t* bonesA = bones + v * MaxBoneInfluences;
+            const uint32_t* bonesB = bonesA + MaxBoneInfluences;
+            const float* weightsA = weights + v * MaxBoneInfluences;
+            const float* weightsB = weightsA + MaxBoneInfluences;
+
+            __m256 r0 = _mm256_setzero_ps();
+            __m256 r1 = _mm256_setzero_ps();
+            __m256 r2 = _mm256_setzero_ps();
+            __m256 r3 = _mm256_setzero_ps();
+            for (size_t i = 0; i < MaxBoneInfluences; ++i) {
+                // weights are sorted, so once both are zero all remaining ones are too; an unused
+                // slot of one vertex blends zeros rather than bone 0 scaled by zero, which would
+                // turn an infinite or NaN bone 0 into NaN
+                if (weightsA[i] == 0.0f && weightsB[i] == 0.0f) {
+                    break;
+                }
+                const float* mA = weightsA[i] != 0.0f ? &boneMatrices[bonesA[i]].a1 : ZeroRows;
+                const float* mB = weightsB[i] != 0.0f ? &boneMatrices[bonesB[i]].a1 : ZeroRows;
+                const __m256 w = broadcastPair(weightsA[i], weightsB[i]);
+                r0 = _mm256_add_ps(r0, _mm256_mul_ps(w, loadPair(mA, mB)));
+                r1 = _mm256_add_ps(r1, _mm256_mul_ps(w, loadPair(mA + 4, mB + 4)));
+                r2 = _mm256_add_ps(r2, _mm256_mul_ps(w, loadPair(mA + 8, mB + 8)));
+            }
+
+            // in-lane transpose, same shuffles as _MM_TRANSPOSE4_PS
+            const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+            const __m256 t1 = _mm256_unpacklo_ps(r2, r3);
+            const __m256 t2 = _mm256_unpackhi_ps(r0, r1);
+            const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+            const __m256 c0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 c1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 c2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 c3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+            const float* pA = srcPositions + v * 3;
+            const float* pB = pA + 3;
+            __m256 p = _mm256_add_ps(_mm256_mul_ps(c0, broadcastPair(pA[0], pB[0])), c3);
+            p = _mm256_add_ps(p, _mm256_mul_ps(c1, broadcastPair(pA[1], pB[1])));
+            p = _mm256_add_ps(p, _mm256_mul_ps(c2, broadcastPair(pA[2], pB[2])));
+            store3(dstPositions + v * 3, _mm256_castps256_ps128(p));
+            store3(dstPositions + v * 3 + 3, _mm256_extractf128_ps(p, 1));
+
+            if (srcNormals && dstNormals) {
+                const float* nA = srcNormals + v * 3;
+                const float* nB = nA + 3;
+                __m256 n = _mm256_mul_ps(c0, broadcastPair(nA[0], nB[0]));
+                n = _mm256_add_ps(n, _mm256_mul_ps(c1, broadcastPair(nA[1], nB[1])));
+                n = _mm256_add_ps(n, _mm256_mul_ps(c2, broadcastPair(nA[2], nB[2])));
+                store3(dstNormals + v * 3, _mm256_castps256_ps128(n));
+                store3(dstNormals + v * 3 + 3, _mm256_extractf128_ps(n, 1));
+            }
+        }
+
+        if (v < first + count) {
+            skinSse(bones, weights, boneMatrices, srcPositions, srcNormals, dstPositions, dstNormals, v, 1);
+        }
+    }
+
+    bool detectAvx() {
+        int leaf1[4] = {0, 0, 0, 0};
+#if defined(_MSC_VER)
+        __cpuid(leaf1, 1);
+#else
+        unsigned a, b, c, d;
+        if (!__get_cpuid(1, &a, &b, &c, &d)) {
+            return false;
+        }
+        leaf1[2] = static_cast<int>(c);
+#endif
+        // AVX needs OS support for saving the ymm registers (OSXSAVE, then XCR0 bits 1 and 2)
+        const bool osxsave = (leaf1[2] & (1 << 27)) != 0;
+        const bool avx = (leaf1[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) {
+            return false;
+        }
+#if defined(_MSC_VER)
+        const unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned xcr0Lo, xcr0Hi;
+        __asm__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+        const unsigned long long xcr0 = xcr0Lo;
+#endif
+        return (xcr0 & 0x6) == 0x6;
+    }
+
+    // cpuid and xgetbv are serializing, so detect once rather than on every skinning job
+    bool cpuSupportsAvx() {
+        static const bool sAvx = detectAvx();
+        return sAvx;
+    }
+#endif
+
+    SkinningKernel getFastestKernel() {
+#ifdef SITARA_ASSIMP_SKINNING_X86
+        if (cpuSupportsAvx()) {
+            return SkinningKernel::Avx;
+        }
+        return SkinningKernel::Sse;
+#else
+        return SkinningKernel::Scalar;
+#endif
+    }
+
+    std::atomic<SkinningKernel>& activeKernel() {
+        static std::atomic<SkinningKernel> sKernel(getFastestKernel());
+        return sKernel;
+    }
+
+    SkinFn getKernelFunction(SkinningKernel kernel) {
+        switch (kernel) {
+#ifdef SITARA_ASSIMP_SKINNING_X86
+            case SkinningKernel::Avx:
+                return skinAvx;
+            case SkinningKernel::Sse:
+                return skinSse;
+#endif
+            default:
+                return skinScalar;
+        }
+    }
+}
+
+bool sitara::assimp::isSkinningKernelSupported(SkinningKernel kernel) {
+    switch (kernel) {
+        case SkinningKernel::Scalar:
+            return true;
+#ifdef SITARA_ASSIMP_SKINNING_X86
+        case SkinningKernel::Sse:
+            return true;
+        case SkinningKernel::Avx:
+            return cpuSupportsAvx();
+#endif
+        default:
+            return false;
+    }
+}
+
+SkinningKernel sitara::assimp::getSkinningKernel() {
+    return activeKernel().load();
+}
+
+void sitara::assimp::setSkinningKernel(SkinningKernel kernel) {
+    activeKernel().store(isSkinningKernelSupported(kernel) ? kernel : SkinningKernel::Scalar);
+}
+
+void sitara::assimp::skinVertices(const BoneInfluences& influences, const aiMatrix4x4* boneMatrices,
+                                  const aiVector3D* srcPositions, const aiVector3D* srcNormals,
+                                  float* dstPositions, float* dstNormals,
+                                  size_t first, size_t count) {
+    skinVertices(getSkinningKernel(), influences, boneMatrices, srcPositions, srcNormals, dstPositions, dstNormals,
+                 first, count);
+}
+
+void sitara::assimp::skinVertices(SkinningKernel kernel, const BoneInfluences& influences,
+                                  const aiMatrix4x4* boneMatrices, const aiVector3D* srcPositions,
+                                  const aiVector3D* srcNormals, float* dstPositions, float* dstNormals,
+                                  size_t first, size_t count) {
+    SkinFn skin = getKernelFunction(isSkinningKernelSupported(kernel) ? kernel : SkinningKernel::Scalar);
+    skin(influences.mBones.data(), influences.mWeights.data(), boneMatrices,
+         reinterpret_cast<const float*>(srcPositions), reinterpret_cast<const float*>(srcNormals),
+         dstPositions, dstNormals, first, count);
+}
@@ -0,0 +1,241 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstddef>
+
+#include "StaticArena.h"
+
+using namespace std;
+using namespace ci;
+using namespace sitara::assimp;
+
+StaticArenaRef StaticArena::create() {
+    return StaticArenaRef(new StaticArena());
+}
+
+StaticArena::StaticArena() : mNumVertices(0), mNumIndices(0), mMultiDrawIndirect(false) {}
+
+bool StaticArena::isMultiDrawIndirectSupported() {
+#if defined(CINDER_GL_ES)
+    return false;
+#else
+    auto version = gl::getVersion();
+    return version.first > 4 || (version.first == 4 && version.second >= 3);
+#endif
+}
+
+void StaticArena::add(AssimpMesh* mesh, NodeHandle node) {
+    Draw draw;
+    draw.mMesh = mesh;
+    draw.mNode = node;
+    draw.mTexture = mesh->mTexture;
+    draw.mSource = mesh;
+    // same (inverted) culling as AssimpLoader::makeRenderItem()
+    draw.mCullFace = mesh->mTwoSided;
+
+    auto it = mMaterialIndices.find(mesh->mMaterialIndex);
+    if (it != mMaterialIndices.end()) {
+        draw.mMaterial = it->second;
+    } else {
+        draw.mMaterial = static_cast<uint32_t>(mMaterials.size());
+        mMaterialIndices[mesh->mMaterialIndex] = draw.mMaterial;
+        mMaterials.push_back(mesh->mMaterial);
+    }
+    if (mesh->mRanges.empty()) {
+        mDraws.push_back(draw);
+        return;
+    }
+    for (const MeshRange& range : mesh->mRanges) {
+        draw.mSource = range.mMesh;
+        draw.mFirstIndex = range.mFirstIndex;
+        draw.mNumIndices = range.mNumIndices;
+        mDraws.push_back(draw);
+    }
+}
+
+void StaticArena::build(bool multiDrawIndirect) {
+    // neighbouring draws share state, so they end up in the same group and in nearby memory
+    std::stable_sort(mDraws.begin(), mDraws.end(), [](const Draw& a, const Draw& b) {
+        if (a.mCullFace != b.mCullFace)
+            return a.mCullFace < b.mCullFace;
+        if (a.mTexture != b.mTexture)
+            return a.mTexture.get() < b.mTexture.get();
+        if (a.mMaterial != b.mMaterial)
+            return a.mMaterial < b.mMaterial;
+        return a.mFirstIndex < b.mFirstIndex;
+    });
+
+    // a mesh referenced by several nodes or split into ranges is stored once
+    std::unordered_map<const AssimpMesh*, std::pair<uint32_t, int32_t>> stored; /// first index and base vertex
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (Draw& draw : mDraws) {
+        const TriMesh& triMesh = *draw.mMesh->mCachedTriMesh;
+        if (draw.mNumIndices == 0) {
+            draw.mNumIndices = static_cast<uint32_t>(triMesh.getNumIndices());
+        }
+
+        auto it = stored.find(draw.mMesh);
+        if (it != stored.end()) {
+            draw.mFirstIndex += it->second.first;
+            draw.mBaseVertex = it->second.second;
+            continue;
+        }
+        stored[draw.mMesh] = std::make_pair(static_cast<uint32_t>(indices.size()), static_cast<int32_t>(vertices.size()));
+        draw.mFirstIndex += static_cast<uint32_t>(indices.size());
+        draw.mBaseVertex = static_cast<int32_t>(vertices.size());
+        indices.insert(indices.end(), triMesh.getIndices().begin(), triMesh.getIndices().end());
+
+        // missing attributes get the values GL would use for a disabled attribute
+        const vec3* positions = triMesh.getPositions<3>();
+        const vec3* normals = triMesh.hasNormals() ? triMesh.getNormals().data() : nullptr;
+        const vec2* texCoords = triMesh.hasTexCoords0() ? triMesh.getTexCoords0<2>() : nullptr;
+        const uint8_t colorDims = triMesh.getAttribDims(geom::Attrib::COLOR);
+        const float* colors = colorDims > 0 ? triMesh.getBufferColors().data() : nullptr;
+        for (size_t v = 0; v < triMesh.getNumVertices(); ++v) {
+            Vertex vertex;
+            vertex.mPosition = positions[v];
+            vertex.mNormal = normals ? normals[v] : vec3(0, 0, 1);
+            vertex.mTexCoord = texCoords ? texCoords[v] : vec2(0);
+            vertex.mColor = ColorAf::white();
+            if (colors) {
+                const float* c = colors + v * colorDims;
+                vertex.mColor = ColorAf(c[0], c[1], c[2], colorDims > 3 ? c[3] : 1.0f);
+            }
+            vertices.push_back(vertex);
+        }
+    }
+    mNumVertices = vertices.size();
+    mNumIndices = indices.size();
+
+    geom::BufferLayout vertexLayout;
+    vertexLayout.append(geom::Attrib::POSITION, 3, sizeof(Vertex), offsetof(Vertex, mPosition));
+    vertexLayout.append(geom::Attrib::NORMAL, 3, sizeof(Vertex), offsetof(Vertex, mNormal));
+    vertexLayout.append(geom::Attrib::TEX_COORD_0, 2, sizeof(Vertex), offsetof(Vertex, mTexCoord));
+    vertexLayout.append(geom::Attrib::COLOR, 4, sizeof(Vertex), offsetof(Vertex, mColor));
+    gl::VboRef vertexVbo = gl::Vbo::create(GL_ARRAY_BUFFER, vertices, GL_STATIC_DRAW);
+
+    // the base instance of every command selects its draw index from this buffer
+    std::vector<float> drawIds(mDraws.size());
+    for (size_t i = 0; i < drawIds.size(); ++i) {
+        drawIds[i] = static_cast<float>(i);
+    }
+    geom::BufferLayout drawIdLayout;
+    drawIdLayout.append(geom::Attrib::CUSTOM_0, 1, 0, 0, 1);
+    gl::VboRef drawIdVbo = gl::Vbo::create(GL_ARRAY_BUFFER, drawIds, GL_STATIC_DRAW);
+
+    gl::VboRef indexVbo = gl::Vbo::create(GL_ELEMENT_ARRAY_BUFFER, indices, GL_STATIC_DRAW);
+    std::vector<std::pair<geom::BufferLayout, gl::VboRef>> buffers = {{vertexLayout, vertexVbo}, {drawIdLayout, drawIdVbo}};
+    mVboMesh = gl::VboMesh::create(static_cast<uint32_t>(mNumVertices), GL_TRIANGLES, buffers,
+                                   static_cast<uint32_t>(mNumIndices), GL_UNSIGNED_INT, indexVbo);
+    mBatches.clear();
+
+    mTransforms.assign(mDraws.size(), mat4(1));
+    mMultiDrawIndirect = multiDrawIndirect && isMultiDrawIndirectSupported();
+    if (mMultiDrawIndirect) {
+        // std430 layout of arena.frag's Material
+        std::vector<vec4> materials;
+        materials.reserve(mMaterials.size() * 5);
+        for (const Material& material : mMaterials) {
+            materials.push_back(vec4(material.mDiffuse.r, material.mDiffuse.g, material.mDiffuse.b, material.mDiffuse.a));
+            materials.push_back(vec4(material.mSpecular.r, material.mSpecular.g, material.mSpecular.b, material.mSpecular.a));
+            materials.push_back(vec4(material.mAmbient.r, material.mAmbient.g, material.mAmbient.b, material.mAmbient.a));
+            materials.push_back(vec4(material.mEmission.r, material.mEmission.g, material.mEmission.b, material.mEmission.a));
+            materials.push_back(vec4(material.mShininess, 0, 0, 0));
+        }
+        std::vector<uint32_t> drawMaterials(mDraws.size());
+        for (size_t i = 0; i < mDraws.size(); ++i) {
+            drawMaterials[i] = mDraws[i].mMaterial;
+        }
+
+        mMaterialBuffer = gl::Ssbo::create(materials.size() * sizeof(vec4), materials.data(), GL_STATIC_DRAW);
+        mDrawMaterialBuffer = gl::Ssbo::create(drawMaterials.size() * sizeof(uint32_t), drawMaterials.data(), GL_STATIC_DRAW);
+        mTransformBuffer = gl::Ssbo::create(mTransforms.size() * sizeof(mat4), mTransforms.data(), GL_STREAM_DRAW);
+        mCommandBuffer = gl::Vbo::create(GL_DRAW_INDIRECT_BUFFER, mDraws.size() * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void StaticArena::updateTransforms(const NodeHierarchy& hierarchy) {
+    for (size_t i = 0; i < mDraws.size(); ++i) {
+        mTransforms[i] = mDraws[i].mNode != InvalidNodeHandle ? hierarchy.getDerivedTransform(mDraws[i].mNode) : mat4(1);
+    }
+    if (mTransformBuffer && !mTransforms.empty()) {
+        mTransformBuffer->bufferSubData(0, mTransforms.size() * sizeof(mat4), mTransforms.data());
+    }
+}
+
+void StaticArena::updateCommands(bool textured) {
+    mCommands.clear();
+    mGroups.clear();
+    for (size_t i = 0; i < mDraws.size(); ++i) {
+        const Draw& draw = mDraws[i];
+        if (!draw.mMesh->mShowMesh || !draw.mSource->mShowMesh)
+            continue;
+
+        gl::Texture2dRef texture = textured ? draw.mTexture : nullptr;
+        if (mGroups.empty() || mGroups.back().mCullFace != draw.mCullFace || mGroups.back().mTexture != texture) {
+            Group group;
+            group.mTexture = texture;
+            group.mCullFace = draw.mCullFace;
+            group.mFirstCommand = mCommands.size();
+            mGroups.push_back(group);
+        }
+        ++mGroups.back().mNumCommands;
+
+        DrawCommand command;
+        command.mCount = draw.mNumIndices;
+        command.mInstanceCount = 1;
+        command.mFirstIndex = draw.mFirstIndex;
+        command.mBaseVertex = draw.mBaseVertex;
+        command.mBaseInstance = static_cast<uint32_t>(i);
+        mCommands.push_back(command);
+    }
+
+    if (mCommandBuffer && !mCommands.empty()) {
+        // orphan, so this frame's commands don't wait for the GPU to finish last frame's
+        mCommandBuffer->bufferData(mDraws.size() * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW);
+        mCommandBuffer->bufferSubData(0, mCommands.size() * sizeof(DrawCommand), mCommands.data());
+    }
+}
+
+void StaticArena::bindBuffers() const {
+    if (mMultiDrawIndirect) {
+        mTransformBuffer->bindBase(0);
+        mMaterialBuffer->bindBase(1);
+        mDrawMaterialBuffer->bindBase(2);
+    }
+}
+
+gl::BatchRef StaticArena::getBatch(const gl::GlslProgRef& shader) {
+    auto it = mBatches.find(shader);
+    if (it != mBatches.end()) {
+        return it->second;
+    }
+
+    // a new shader; drop the batches of shaders nobody but this cache and its batch holds anymore
+    for (auto old = mBatches.begin(); old != mBatches.end();) {
+        old = old->first.use_count() <= 2 ? mBatches.erase(old) : std::next(old);
+    }
+    gl::BatchRef batch = gl::Batch::create(mVboMesh, shader, {{geom::Attrib::CUSTOM_0, "iDrawId"}});
+    mBatches[shader] = batch;
+    return batch;
+}
+
+size_t StaticArena::getNumBytes() const {
+    return mNumVertices * sizeof(Vertex) + mNumIndices * sizeof(uint32_t) + mDraws.size() * sizeof(float);
+}
@@ -0,0 +1,108 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "cinder/gl/scoped.h"
+
+#include "StreamingBuffer.h"
+
+using namespace std;
+using namespace ci;
+using namespace sitara::assimp;
+
+StreamingBufferRef StreamingBuffer::create(size_t regionBytes, size_t numRegions) {
+    return StreamingBufferRef(new StreamingBuffer(regionBytes, numRegions));
+}
+
+StreamingBuffer::StreamingBuffer(size_t regionBytes, size_t numRegions)
+    : mRegionBytes(regionBytes),
+      mNumRegions(1),
+      mRegion(0),
+      mPendingRegion(0),
+      mPersistent(false),
+      mMapped(nullptr),
+      mUploadBytes(0),
+      mNumStalls(0) {
+#if !defined(CINDER_GL_ES)
+    auto version = gl::getVersion();
+    if (numRegions > 1 && (version.first > 4 || (version.first == 4 && version.second >= 4))) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        mVbo = gl::Vbo::create(GL_ARRAY_BUFFER);
+        gl::ScopedBuffer scopedBuffer(mVbo);
+        glBufferStorage(GL_ARRAY_BUFFER, regionBytes * numRegions, nullptr, flags);
+        mMapped = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, regionBytes * numRegions, flags));
+        mPersistent = mMapped != nullptr;
+        if (mPersistent) {
+            mNumRegions = numRegions;
+        }
+    }
+#endif
+
+    if (!mPersistent) {
+        mVbo = gl::Vbo::create(GL_ARRAY_BUFFER, regionBytes, nullptr, GL_STREAM_DRAW);
+        mStaging.resize(regionBytes);
+    }
+    mFences.assign(mNumRegions, nullptr);
+}
+
+StreamingBuffer::~StreamingBuffer() {
+    for (GLsync fence : mFences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+}
+
+uint8_t* StreamingBuffer::beginWrite() {
+    if (!mPersistent) {
+        return mStaging.data();
+    }
+
+    // everything reading the current region has been submitted by now; fence it and move on
+    if (mFences[mRegion]) {
+        glDeleteSync(mFences[mRegion]);
+    }
+    mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    const size_t next = (mRegion + 1) % mNumRegions;
+    if (GLsync fence = mFences[next]) {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            ++mNumStalls;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        mFences[next] = nullptr;
+    }
+
+    mPendingRegion = next;
+    return mMapped + getRegionOffset(next);
+}
+
+void StreamingBuffer::endWrite(size_t bytes) {
+    mUploadBytes += bytes;
+    if (mPersistent) {
+        // the mapping is coherent, so the data is visible to draws issued from now on
+        mRegion = mPendingRegion;
+        return;
+    }
+
+    // orphan the storage the GPU may still be reading and upload into fresh storage
+    mVbo->bufferData(mRegionBytes, nullptr, GL_STREAM_DRAW);
+    mVbo->bufferSubData(0, bytes, mStaging.data());
+}
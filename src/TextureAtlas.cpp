@@ -0,0 +1,121 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <numeric>
+
+#include "TextureAtlas.h"
+
+using namespace std;
+using namespace ci;
+using namespace sitara::assimp;
+
+TextureAtlasRef TextureAtlas::create(int pageSize, int padding) {
+    return TextureAtlasRef(new TextureAtlas(pageSize, padding));
+}
+
+TextureAtlas::TextureAtlas(int pageSize, int padding) : mPageSize(pageSize), mPadding(padding), mOccupancy(0) {}
+
+bool TextureAtlas::add(const std::string& key, const ci::Surface8u& surface) {
+    if (surface.getWidth() + 2 * mPadding > mPageSize || surface.getHeight() + 2 * mPadding > mPageSize) {
+        return false;
+    }
+    if (contains(key)) {
+        return true;
+    }
+
+    mIndices[key] = mTiles.size();
+    mTiles.push_back(Tile());
+    mSurfaces.push_back(surface);
+    return true;
+}
+
+void TextureAtlas::pack() {
+    // tallest first, so every shelf wastes little height
+    vector<size_t> order(mTiles.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return mSurfaces[a].getHeight() > mSurfaces[b].getHeight();
+    });
+
+    vector<int> pageHeights;
+    int x = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    for (size_t i : order) {
+        const int width = mSurfaces[i].getWidth() + 2 * mPadding;
+        const int height = mSurfaces[i].getHeight() + 2 * mPadding;
+        if (pageHeights.empty() || x + width > mPageSize) {
+            // next shelf, or next page if the shelf would leave this one
+            shelfY += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+            if (pageHeights.empty() || shelfY + height > mPageSize) {
+                pageHeights.push_back(0);
+                shelfY = 0;
+            }
+        }
+
+        Tile& tile = mTiles[i];
+        tile.mPage = pageHeights.size() - 1;
+        tile.mArea = Area(x + mPadding, shelfY + mPadding, x + width - mPadding, shelfY + height - mPadding);
+        x += width;
+        shelfHeight = std::max(shelfHeight, height);
+        pageHeights.back() = std::max(pageHeights.back(), shelfY + shelfHeight);
+    }
+
+    vector<Surface8u> pages;
+    for (int height : pageHeights) {
+        pages.push_back(Surface8u(mPageSize, height, true));
+        std::fill(pages.back().getData(), pages.back().getData() + pages.back().getRowBytes() * height, uint8_t(0));
+    }
+
+    size_t coveredPixels = 0;
+    for (size_t i = 0; i < mTiles.size(); ++i) {
+        Tile& tile = mTiles[i];
+        Surface8u& page = pages[tile.mPage];
+        const Area& area = tile.mArea;
+        page.copyFrom(mSurfaces[i], mSurfaces[i].getBounds(), area.getUL());
+        coveredPixels += area.calcArea();
+
+        // repeat the edge pixels into the padding
+        for (int p = 1; p <= mPadding; ++p) {
+            page.copyFrom(page, Area(area.x1, area.y1, area.x2, area.y1 + 1), ivec2(0, -p));
+            page.copyFrom(page, Area(area.x1, area.y2 - 1, area.x2, area.y2), ivec2(0, p));
+        }
+        for (int p = 1; p <= mPadding; ++p) {
+            page.copyFrom(page, Area(area.x1, area.y1 - mPadding, area.x1 + 1, area.y2 + mPadding), ivec2(-p, 0));
+            page.copyFrom(page, Area(area.x2 - 1, area.y1 - mPadding, area.x2, area.y2 + mPadding), ivec2(p, 0));
+        }
+
+        // textures are flipped on upload, so t runs from the bottom of the image
+        const float width = static_cast<float>(page.getWidth());
+        const float height = static_cast<float>(page.getHeight());
+        tile.mTexCoords = Rectf(area.x1 / width, 1.0f - area.y2 / height, area.x2 / width, 1.0f - area.y1 / height);
+    }
+    mSurfaces.clear();
+
+    size_t pagePixels = 0;
+    gl::Texture::Format format;
+    format.mipmap().minFilter(GL_LINEAR_MIPMAP_LINEAR).magFilter(GL_LINEAR).wrap(GL_CLAMP_TO_EDGE);
+    mPages.clear();
+    for (const Surface8u& page : pages) {
+        mPages.push_back(gl::Texture2d::create(page, format));
+        pagePixels += page.getWidth() * page.getHeight();
+    }
+    mOccupancy = pagePixels > 0 ? static_cast<float>(coveredPixels) / pagePixels : 0.0f;
+}
@@ -0,0 +1,175 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <exception>
+
+#include "ThreadPool.h"
+
+using namespace std;
+using namespace sitara::assimp;
+
+namespace {
+    // the pool (and queue) owning the current thread, if it is a worker thread
+    thread_local const ThreadPool* sWorkerPool = nullptr;
+    thread_local size_t sWorkerQueue = 0;
+
+    struct ParallelForState {
+        std::atomic<size_t> mRemaining;
+        std::mutex mErrorMutex;
+        std::exception_ptr mError;
+    };
+}
+
+ThreadPoolRef ThreadPool::create(size_t numThreads) {
+    if (numThreads == 0) {
+        numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    return ThreadPoolRef(new ThreadPool(numThreads));
+}
+
+ThreadPool::ThreadPool(size_t numThreads) : mNumQueued(0), mStopping(false) {
+    // queue 0 is shared by all threads outside of the pool; every worker gets its own
+    for (size_t i = 0; i < numThreads; ++i) {
+        mQueues.push_back(std::unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for (size_t i = 1; i < numThreads; ++i) {
+        mThreads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mStopping = true;
+    }
+    mWakeCondition.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+
+    if (mThreads.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    // tasks only reference the state and the task function; both outlive them because we
+    // block until mRemaining drops to zero
+    ParallelForState state;
+    state.mRemaining = count;
+
+    size_t homeQueue = getHomeQueue();
+    for (size_t i = 0; i < count; ++i) {
+        push((homeQueue + i) % mQueues.size(), [&state, &task, i]() {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state.mErrorMutex);
+                if (!state.mError) {
+                    state.mError = std::current_exception();
+                }
+            }
+            state.mRemaining.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+    mWakeCondition.notify_all();
+
+    while (state.mRemaining.load(std::memory_order_acquire) > 0) {
+        if (!runPendingTask(homeQueue)) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (state.mError) {
+        std::rethrow_exception(state.mError);
+    }
+}
+
+void ThreadPool::push(size_t queueIndex, std::function<void()> task) {
+    {
+        // count before publishing so mNumQueued never drops below the number of queued tasks;
+        // incrementing under the wake mutex means a worker about to sleep can't miss the task
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mNumQueued.fetch_add(1, std::memory_order_release);
+    }
+    std::lock_guard<std::mutex> lock(mQueues[queueIndex]->mMutex);
+    mQueues[queueIndex]->mTasks.push_back(std::move(task));
+}
+
+bool ThreadPool::runPendingTask(size_t homeQueue) {
+    std::function<void()> task;
+
+    // newest task from our own queue first, it's the most likely to be warm in cache
+    {
+        TaskQueue& queue = *mQueues[homeQueue];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        if (!queue.mTasks.empty()) {
+            task = std::move(queue.mTasks.back());
+            queue.mTasks.pop_back();
+        }
+    }
+
+    // otherwise steal the oldest task of another queue
+    for (size_t i = 1; !task && i < mQueues.size(); ++i) {
+        TaskQueue& queue = *mQueues[(homeQueue + i) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(queue.mMutex);
+        if (!queue.mTasks.empty()) {
+            task = std::move(queue.mTasks.front());
+            queue.mTasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    mNumQueued.fetch_sub(1, std::memory_order_acq_rel);
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t queueIndex) {
+    sWorkerPool = this;
+    sWorkerQueue = queueIndex;
+
+    while (true) {
+        if (runPendingTask(queueIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWakeCondition.wait(lock, [this]() { return mStopping || mNumQueued.load(std::memory_order_acquire) > 0; });
+        if (mStopping && mNumQueued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+size_t ThreadPool::getHomeQueue() {
+    if (sWorkerPool == this) {
+        return sWorkerQueue;
+    }
+    return 0;
+}
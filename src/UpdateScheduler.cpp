@@ -0,0 +1,63 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <numeric>
+
+#include "cinder/Timer.h"
+
+#include "UpdateScheduler.h"
+
+using namespace std;
+using namespace ci;
+using namespace sitara::assimp;
+
+UpdateSchedulerRef UpdateScheduler::create(size_t numThreads) {
+    return create(ThreadPool::create(numThreads));
+}
+
+UpdateSchedulerRef UpdateScheduler::create(ThreadPoolRef pool) {
+    return UpdateSchedulerRef(new UpdateScheduler(pool));
+}
+
+UpdateScheduler::UpdateScheduler(ThreadPoolRef pool) : mThreadPool(pool) {}
+
+void UpdateScheduler::update(const std::vector<AssimpLoaderRef>& loaders) {
+    Timer wallTimer(true);
+
+    mLoaderSeconds.assign(loaders.size(), 0.0);
+    mThreadPool->parallelFor(loaders.size(), [&](size_t i) {
+        Timer loaderTimer(true);
+        loaders[i]->update();
+        mLoaderSeconds[i] = loaderTimer.getSeconds();
+    });
+
+    // GL calls stay serial and on this thread
+    Timer gpuTimer(true);
+    uint64_t uploadBytes = 0;
+    for (const AssimpLoaderRef& loader : loaders) {
+        const uint64_t previousBytes = loader->getUploadBytes();
+        loader->updateGpu();
+        uploadBytes += loader->getUploadBytes() - previousBytes;
+    }
+    mLastStats.mGpuSeconds = gpuTimer.getSeconds();
+    mLastStats.mUploadBytes = uploadBytes;
+
+    mLastStats.mNumThreads = mThreadPool->getNumThreads();
+    mLastStats.mNumLoaders = loaders.size();
+    mLastStats.mWallSeconds = wallTimer.getSeconds();
+    mLastStats.mBusySeconds = std::accumulate(mLoaderSeconds.begin(), mLoaderSeconds.end(), 0.0);
+}
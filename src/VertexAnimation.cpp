@@ -0,0 +1,363 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <optional>
+
+#include "glm/gtc/matrix_inverse.hpp"
+#include "glm/gtc/packing.hpp"
+
+#include "VertexAnimation.h"
+#include "Skinning.h"
+
+using namespace std;
+using namespace ci;
+using namespace sitara::assimp;
+
+namespace {
+    const char FileMagic[4] = {'S', 'V', 'A', 'T'};
+    const uint32_t FileVersion = 1;
+    const uint32_t FileHalfFloat = 1 << 0;
+    const uint32_t FileNormals = 1 << 1;
+
+    struct FileHeader {
+        char mMagic[4];
+        uint32_t mVersion;
+        uint32_t mFlags;
+        uint32_t mNumFrames;
+        uint32_t mNumMeshes;
+        uint32_t mTextureWidth;
+        uint32_t mRowsPerFrame;
+        float mSampleRate;
+        float mMaxPositionError;
+        float mMaxNormalError;
+    };
+
+    template <typename T>
+    void writeArray(std::ofstream& stream, const std::vector<T>& data) {
+        stream.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+    }
+
+    //! Stores \a a times \a b in \a result, or returns false if the product doesn't fit.
+    bool multiply(uint64_t a, uint64_t b, uint64_t* result) {
+        if (a != 0 && b > UINT64_MAX / a) {
+            return false;
+        }
+        *result = a * b;
+        return true;
+    }
+
+    template <typename T>
+    void readArray(std::ifstream& stream, std::vector<T>& data, size_t size) {
+        data.resize(size);
+        stream.read(reinterpret_cast<char*>(data.data()), size * sizeof(T));
+    }
+
+    //! Puts back the animation, time, skinning and skinning kernel of a loader on restore() or
+    // destruction, whichever comes first.
+    class LoaderSettingsGuard {
+      public:
+        explicit LoaderSettingsGuard(const AssimpLoaderRef& loader)
+            : mLoader(loader),
+              mAnimation(loader->getAnimation()),
+              mTime(loader->getTime()),
+              mAnimationEnabled(loader->isAnimationEnabled()),
+              mSkinningEnabled(loader->isSkinningEnabled()),
+              mKernel(loader->getSkinningKernel()) {}
+        ~LoaderSettingsGuard() { restore(); }
+
+        LoaderSettingsGuard(const LoaderSettingsGuard&) = delete;
+        LoaderSettingsGuard& operator=(const LoaderSettingsGuard&) = delete;
+
+        void restore() {
+            if (!mLoader) {
+                return;
+            }
+            mLoader->setSkinningKernel(mKernel);
+            mLoader->setAnimation(mAnimation);
+            mLoader->setTime(mTime);
+            mLoader->enableAnimation(mAnimationEnabled);
+            mLoader->enableSkinning(mSkinningEnabled);
+            mLoader = nullptr;
+        }
+
+      private:
+        AssimpLoaderRef mLoader;
+        size_t mAnimation;
+        double mTime;
+        bool mAnimationEnabled;
+        bool mSkinningEnabled;
+        std::optional<SkinningKernel> mKernel;
+    };
+}
+
+VertexAnimation::VertexAnimation()
+    : mNumFrames(0),
+      mSampleRate(0.0f),
+      mHalfFloat(false),
+      mTextureWidth(0),
+      mRowsPerFrame(0),
+      mMaxPositionError(0.0f),
+      mMaxNormalError(0.0f) {}
+
+VertexAnimationRef VertexAnimation::bake(const AssimpLoaderRef& loader, size_t animation, const Format& format) {
+    if (animation >= loader->getNumAnimations()) {
+        throw AssimpLoaderExc("cannot bake animation " + toString(animation) + "; the model has " +
+                              toString(loader->getNumAnimations()) + " animations");
+    }
+    if (format.mSampleRate <= 0.0f || format.mTextureWidth <= 0) {
+        throw AssimpLoaderExc("vertex animation needs a positive sample rate and texture width");
+    }
+
+    VertexAnimationRef vat(new VertexAnimation());
+    vat->mHalfFloat = format.mHalfFloat;
+    vat->mTextureWidth = format.mTextureWidth;
+
+    // evenly spaced frames including both ends of the clip, so the last frame is the end of the
+    // clip, which vat.vert wraps to frame 0; the sample rate is adjusted to fit the duration
+    const double duration = loader->getAnimationDuration(animation);
+    const size_t numIntervals = static_cast<size_t>(std::round(duration * format.mSampleRate));
+    vat->mNumFrames = numIntervals + 1;
+    vat->mSampleRate = numIntervals > 0 ? static_cast<float>(numIntervals / duration) : format.mSampleRate;
+
+    vat->mMeshOffsets.push_back(0);
+    for (size_t n = 0; n < loader->getNumMeshes(); ++n) {
+        vat->mMeshOffsets.push_back(vat->mMeshOffsets.back() + static_cast<uint32_t>(loader->getTriMesh(n)->getNumVertices()));
+    }
+    vat->mRowsPerFrame = std::max<int>(1, static_cast<int>((vat->getNumVertices() + format.mTextureWidth - 1) / format.mTextureWidth));
+    vat->allocate();
+    if (!format.mNormals) {
+        vat->mNormals.clear();
+        vat->mHalfNormals.clear();
+    }
+
+    // drive the loader through the clip; its own settings are put back when the guard goes out
+    // of scope, also when skinning throws
+    LoaderSettingsGuard guard(loader);
+    if (format.mScalarSkinning) {
+        loader->setSkinningKernel(SkinningKernel::Scalar);
+    }
+    loader->setAnimation(animation);
+    loader->enableAnimation();
+    loader->enableSkinning();
+
+    const NodeHierarchyRef hierarchy = loader->getNodeHierarchy();
+    for (size_t frame = 0; frame < vat->mNumFrames; ++frame) {
+        loader->setTime(numIntervals > 0 ? duration * frame / numIntervals : 0.0);
+        loader->update();
+
+        for (size_t n = 0; n < loader->getNumMeshes(); ++n) {
+            const TriMeshRef triMesh = loader->getTriMesh(n);
+            const vec3* positions = triMesh->getPositions<3>();
+            const std::vector<vec3>& normals = triMesh->getNormals();
+
+            // skinned vertices are in model space already; rigid meshes are moved there by their
+            // node, as draw() places them, so node animation is baked as well
+            const NodeHandle node = loader->getMeshNode(n);
+            const mat4 transform = node != InvalidNodeHandle ? hierarchy->getDerivedTransform(node) : mat4(1.0f);
+            const mat3 normalTransform = glm::inverseTranspose(mat3(transform));
+            for (size_t v = 0; v < triMesh->getNumVertices(); ++v) {
+                const size_t texel = vat->getTexelIndex(frame, vat->mMeshOffsets[n] + v);
+                const vec3 position = node != InvalidNodeHandle ? vec3(transform * vec4(positions[v], 1.0f)) : positions[v];
+                vat->store(vat->mPositions, vat->mHalfPositions, texel, position, &vat->mMaxPositionError);
+                if (format.mNormals) {
+                    vec3 normal = v < normals.size() ? normals[v] : vec3(0);
+                    if (node != InvalidNodeHandle && normal != vec3(0)) {
+                        normal = glm::normalize(normalTransform * normal);
+                    }
+                    vat->store(vat->mNormals, vat->mHalfNormals, texel, normal, &vat->mMaxNormalError);
+                }
+            }
+        }
+    }
+
+    // bring the meshes back to the restored state; skipped when unwinding, where it could throw again
+    guard.restore();
+    loader->update();
+
+    return vat;
+}
+
+void VertexAnimation::allocate() {
+    const size_t numFloats = static_cast<size_t>(mTextureWidth) * getTextureHeight() * 4;
+    mPositions.clear();
+    mNormals.clear();
+    mHalfPositions.clear();
+    mHalfNormals.clear();
+    if (mHalfFloat) {
+        mHalfPositions.assign(numFloats, 0);
+        mHalfNormals.assign(numFloats, 0);
+    } else {
+        mPositions.assign(numFloats, 0.0f);
+        mNormals.assign(numFloats, 0.0f);
+    }
+}
+
+size_t VertexAnimation::getTexelIndex(size_t frame, size_t vertex) const {
+    return frame * mRowsPerFrame * mTextureWidth + vertex;
+}
+
+void VertexAnimation::store(std::vector<float>& data, std::vector<uint16_t>& halfData, size_t texel, const vec3& v, float* maxError) {
+    for (int c = 0; c < 3; ++c) {
+        if (mHalfFloat) {
+            halfData[texel * 4 + c] = glm::packHalf1x16(v[c]);
+            *maxError = std::max(*maxError, std::abs(glm::unpackHalf1x16(halfData[texel * 4 + c]) - v[c]));
+        } else {
+            data[texel * 4 + c] = v[c];
+        }
+    }
+}
+
+vec3 VertexAnimation::fetch(const std::vector<float>& data, const std::vector<uint16_t>& halfData, size_t texel) const {
+    if (mHalfFloat) {
+        return vec3(glm::unpackHalf1x16(halfData[texel * 4]), glm::unpackHalf1x16(halfData[texel * 4 + 1]),
+                    glm::unpackHalf1x16(halfData[texel * 4 + 2]));
+    }
+    return vec3(data[texel * 4], data[texel * 4 + 1], data[texel * 4 + 2]);
+}
+
+vec3 VertexAnimation::getPosition(size_t frame, size_t vertex) const {
+    return fetch(mPositions, mHalfPositions, getTexelIndex(frame, vertex));
+}
+
+vec3 VertexAnimation::getNormal(size_t frame, size_t vertex) const {
+    return fetch(mNormals, mHalfNormals, getTexelIndex(frame, vertex));
+}
+
+size_t VertexAnimation::getNumBytes() const {
+    return (mPositions.size() + mNormals.size()) * sizeof(float) +
+           (mHalfPositions.size() + mHalfNormals.size()) * sizeof(uint16_t);
+}
+
+gl::Texture2dRef VertexAnimation::createTexture(const std::vector<float>& data, const std::vector<uint16_t>& halfData) const {
+    auto format = gl::Texture2d::Format()
+                      .internalFormat(mHalfFloat ? GL_RGBA16F : GL_RGBA32F)
+                      .dataType(mHalfFloat ? GL_HALF_FLOAT : GL_FLOAT)
+                      .minFilter(GL_NEAREST)
+                      .magFilter(GL_NEAREST)
+                      .mipmap(false);
+    const void* texels = mHalfFloat ? static_cast<const void*>(halfData.data()) : static_cast<const void*>(data.data());
+    return gl::Texture2d::create(texels, GL_RGBA, mTextureWidth, getTextureHeight(), format);
+}
+
+gl::Texture2dRef VertexAnimation::createPositionTexture() const {
+    return createTexture(mPositions, mHalfPositions);
+}
+
+gl::Texture2dRef VertexAnimation::createNormalTexture() const {
+    if (!hasNormals()) {
+        return nullptr;
+    }
+    return createTexture(mNormals, mHalfNormals);
+}
+
+void VertexAnimation::save(const fs::path& path) const {
+    std::ofstream stream(path.string(), std::ios::binary);
+    if (!stream) {
+        throw AssimpLoaderExc("could not write vertex animation " + path.string());
+    }
+
+    FileHeader header;
+    std::copy(FileMagic, FileMagic + 4, header.mMagic);
+    header.mVersion = FileVersion;
+    header.mFlags = (mHalfFloat ? FileHalfFloat : 0) | (hasNormals() ? FileNormals : 0);
+    header.mNumFrames = static_cast<uint32_t>(mNumFrames);
+    header.mNumMeshes = static_cast<uint32_t>(getNumMeshes());
+    header.mTextureWidth = static_cast<uint32_t>(mTextureWidth);
+    header.mRowsPerFrame = static_cast<uint32_t>(mRowsPerFrame);
+    header.mSampleRate = mSampleRate;
+    header.mMaxPositionError = mMaxPositionError;
+    header.mMaxNormalError = mMaxNormalError;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    writeArray(stream, mMeshOffsets);
+    if (mHalfFloat) {
+        writeArray(stream, mHalfPositions);
+        writeArray(stream, mHalfNormals);
+    } else {
+        writeArray(stream, mPositions);
+        writeArray(stream, mNormals);
+    }
+}
+
+VertexAnimationRef VertexAnimation::load(const fs::path& path) {
+    std::ifstream stream(path.string(), std::ios::binary);
+    if (!stream) {
+        throw AssimpLoaderExc("could not read vertex animation " + path.string());
+    }
+
+    FileHeader header;
+    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!stream || !std::equal(FileMagic, FileMagic + 4, header.mMagic) || header.mVersion != FileVersion ||
+        header.mTextureWidth == 0 || header.mRowsPerFrame == 0 || header.mNumFrames == 0 ||
+        header.mNumMeshes == UINT32_MAX || header.mTextureWidth > INT_MAX ||
+        header.mRowsPerFrame > INT_MAX / header.mNumFrames) {
+        throw AssimpLoaderExc(path.string() + " is not a vertex animation");
+    }
+
+    // a corrupt header must not turn into a huge allocation, so the sizes it implies are checked
+    // against the bytes the file actually holds before anything is read
+    const std::streamoff headerEnd = stream.tellg();
+    stream.seekg(0, std::ios::end);
+    const uint64_t remaining = static_cast<uint64_t>(stream.tellg() - headerEnd);
+    stream.seekg(headerEnd);
+
+    const uint64_t numOffsets = static_cast<uint64_t>(header.mNumMeshes) + 1;
+    const uint64_t elementSize = (header.mFlags & FileHalfFloat) ? sizeof(uint16_t) : sizeof(float);
+    const uint64_t numTextures = (header.mFlags & FileNormals) ? 2 : 1;
+    uint64_t numFloats = 0;
+    uint64_t payload = 0;
+    if (!multiply(header.mTextureWidth, static_cast<uint64_t>(header.mRowsPerFrame) * header.mNumFrames, &numFloats) ||
+        !multiply(numFloats, 4, &numFloats) || !multiply(numFloats, elementSize * numTextures, &payload) ||
+        payload > UINT64_MAX - numOffsets * sizeof(uint32_t) || remaining < payload + numOffsets * sizeof(uint32_t)) {
+        throw AssimpLoaderExc(path.string() + " is truncated");
+    }
+
+    VertexAnimationRef vat(new VertexAnimation());
+    vat->mNumFrames = header.mNumFrames;
+    vat->mSampleRate = header.mSampleRate;
+    vat->mHalfFloat = (header.mFlags & FileHalfFloat) != 0;
+    vat->mTextureWidth = static_cast<int>(header.mTextureWidth);
+    vat->mRowsPerFrame = static_cast<int>(header.mRowsPerFrame);
+    vat->mMaxPositionError = header.mMaxPositionError;
+    vat->mMaxNormalError = header.mMaxNormalError;
+
+    // the offsets start at 0 and ascend, so every mesh addresses a valid range of texels
+    readArray(stream, vat->mMeshOffsets, static_cast<size_t>(numOffsets));
+    if (!stream || vat->mMeshOffsets.front() != 0 ||
+        !std::is_sorted(vat->mMeshOffsets.begin(), vat->mMeshOffsets.end()) ||
+        vat->getNumVertices() > static_cast<size_t>(vat->mTextureWidth) * vat->mRowsPerFrame) {
+        throw AssimpLoaderExc(path.string() + " is not a vertex animation");
+    }
+
+    const size_t numNormalFloats = (header.mFlags & FileNormals) ? static_cast<size_t>(numFloats) : 0;
+    if (vat->mHalfFloat) {
+        readArray(stream, vat->mHalfPositions, static_cast<size_t>(numFloats));
+        readArray(stream, vat->mHalfNormals, numNormalFloats);
+    } else {
+        readArray(stream, vat->mPositions, static_cast<size_t>(numFloats));
+        readArray(stream, vat->mNormals, numNormalFloats);
+    }
+    if (!stream) {
+        throw AssimpLoaderExc(path.string() + " is truncated");
+    }
+
+    return vat;
+}
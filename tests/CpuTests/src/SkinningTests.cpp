@@ -0,0 +1,231 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "Skinning.h"
+
+using namespace sitara::assimp;
+
+namespace {
+    const SkinningKernel Kernels[] = {SkinningKernel::Scalar, SkinningKernel::Sse, SkinningKernel::Avx};
+
+    //! Random rotations, scales and translations, so every row of the palette matters.
+    std::vector<aiMatrix4x4> makePalette(size_t numBones, std::mt19937& rng) {
+        std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+        std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+        std::vector<aiMatrix4x4> palette(numBones);
+        for (aiMatrix4x4& m : palette) {
+            const float a = angle(rng);
+            const float b = angle(rng);
+            const float s = scale(rng);
+            // rotation about z, then about x, then a uniform scale
+            m = aiMatrix4x4(s * std::cos(a), -s * std::sin(a), 0.0f, offset(rng),
+                            s * std::sin(a) * std::cos(b), s * std::cos(a) * std::cos(b), -s * std::sin(b), offset(rng),
+                            s * std::sin(a) * std::sin(b), s * std::cos(a) * std::sin(b), s * std::cos(b), offset(rng),
+                            0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        return palette;
+    }
+
+    //! One to MaxBoneInfluences random bones per vertex, sorted by decreasing weight and
+    // normalized like buildBoneInfluences() leaves them.
+    BoneInfluences makeInfluences(size_t numVertices, size_t numBones, std::mt19937& rng) {
+        std::uniform_int_distribution<uint32_t> bone(0, static_cast<uint32_t>(numBones - 1));
+        std::uniform_int_distribution<size_t> count(1, MaxBoneInfluences);
+        std::uniform_real_distribution<float> weight(0.01f, 1.0f);
+
+        BoneInfluences influences;
+        influences.mBones.assign(numVertices * MaxBoneInfluences, 0);
+        influences.mWeights.assign(numVertices * MaxBoneInfluences, 0.0f);
+        for (size_t v = 0; v < numVertices; ++v) {
+            float* weights = &influences.mWeights[v * MaxBoneInfluences];
+            const size_t n = count(rng);
+            for (size_t i = 0; i < n; ++i) {
+                influences.mBones[v * MaxBoneInfluences + i] = bone(rng);
+                weights[i] = weight(rng);
+            }
+            std::sort(weights, weights + n, [](float a, float b) { return a > b; });
+            float sum = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                sum += weights[i];
+            }
+            for (size_t i = 0; i < n; ++i) {
+                weights[i] /= sum;
+            }
+        }
+        return influences;
+    }
+
+    std::vector<aiVector3D> makeVectors(size_t count, std::mt19937& rng) {
+        std::uniform_real_distribution<float> coordinate(-5.0f, 5.0f);
+        std::vector<aiVector3D> vectors(count);
+        for (aiVector3D& v : vectors) {
+            v = aiVector3D(coordinate(rng), coordinate(rng), coordinate(rng));
+        }
+        return vectors;
+    }
+
+    //! Skins \a count vertices from \a first with \a kernel into \a positions and \a normals.
+    void skin(SkinningKernel kernel, const BoneInfluences& influences, const std::vector<aiMatrix4x4>& palette,
+              const std::vector<aiVector3D>& srcPositions, const std::vector<aiVector3D>& srcNormals,
+              std::vector<float>& positions, std::vector<float>& normals, size_t first, size_t count) {
+        skinVertices(kernel, influences, palette.data(), srcPositions.data(), srcNormals.data(), positions.data(),
+                     normals.data(), first, count);
+    }
+}
+
+TEST(Skinning, KernelsMatchScalarOnRandomInfluences) {
+    std::mt19937 rng(7);
+    const size_t numVertices = 1001;
+    const std::vector<aiMatrix4x4> palette = makePalette(64, rng);
+    const BoneInfluences influences = makeInfluences(numVertices, palette.size(), rng);
+    const std::vector<aiVector3D> srcPositions = makeVectors(numVertices, rng);
+    const std::vector<aiVector3D> srcNormals = makeVectors(numVertices, rng);
+
+    std::vector<float> expectedPositions(numVertices * 3);
+    std::vector<float> expectedNormals(numVertices * 3);
+    skin(SkinningKernel::Scalar, influences, palette, srcPositions, srcNormals, expectedPositions, expectedNormals, 0,
+         numVertices);
+
+    for (SkinningKernel kernel : Kernels) {
+        if (!isSkinningKernelSupported(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(static_cast<int>(kernel));
+        std::vector<float> positions(numVertices * 3);
+        std::vector<float> normals(numVertices * 3);
+        skin(kernel, influences, palette, srcPositions, srcNormals, positions, normals, 0, numVertices);
+
+        // the SIMD kernels blend the matrices first, which only changes the rounding
+        for (size_t i = 0; i < numVertices * 3; ++i) {
+            ASSERT_NEAR(positions[i], expectedPositions[i], 1e-4f * std::max(1.0f, std::abs(expectedPositions[i])));
+            ASSERT_NEAR(normals[i], expectedNormals[i], 1e-4f * std::max(1.0f, std::abs(expectedNormals[i])));
+        }
+    }
+}
+
+TEST(Skinning, KernelsOnlyWriteTheRequestedRange) {
+    std::mt19937 rng(11);
+    const size_t numVertices = 16;
+    const std::vector<aiMatrix4x4> palette = makePalette(4, rng);
+    const BoneInfluences influences = makeInfluences(numVertices, palette.size(), rng);
+    const std::vector<aiVector3D> srcPositions = makeVectors(numVertices, rng);
+    const std::vector<aiVector3D> srcNormals = makeVectors(numVertices, rng);
+
+    for (SkinningKernel kernel : Kernels) {
+        if (!isSkinningKernelSupported(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(static_cast<int>(kernel));
+        // an odd count starting at an odd vertex leaves a single vertex for the tail of the AVX kernel
+        const float sentinel = -12345.0f;
+        std::vector<float> positions(numVertices * 3, sentinel);
+        std::vector<float> normals(numVertices * 3, sentinel);
+        skin(kernel, influences, palette, srcPositions, srcNormals, positions, normals, 3, 7);
+        for (size_t v = 0; v < numVertices; ++v) {
+            const bool inside = v >= 3 && v < 10;
+            for (size_t c = 0; c < 3; ++c) {
+                EXPECT_EQ(positions[v * 3 + c] != sentinel, inside) << "vertex " << v;
+                EXPECT_EQ(normals[v * 3 + c] != sentinel, inside) << "vertex " << v;
+            }
+        }
+    }
+}
+
+TEST(Skinning, UnusedSlotsIgnoreBoneZero) {
+    std::mt19937 rng(13);
+    const size_t numVertices = 9;
+    std::vector<aiMatrix4x4> palette = makePalette(3, rng);
+    const float inf = std::numeric_limits<float>::infinity();
+    palette[0] = aiMatrix4x4(inf, inf, inf, inf, inf, inf, inf, inf, inf, inf, inf, inf, 0, 0, 0, 1);
+
+    // every vertex uses bones 1 and 2 only, with between one and MaxBoneInfluences - 1 unused
+    // slots; the padded slots point at bone 0
+    BoneInfluences influences = makeInfluences(numVertices, 2, rng);
+    for (size_t i = 0; i < influences.mBones.size(); ++i) {
+        influences.mBones[i] = influences.mWeights[i] > 0.0f ? influences.mBones[i] + 1 : 0;
+        if (i % MaxBoneInfluences == MaxBoneInfluences - 1) {
+            influences.mWeights[i] = 0.0f;
+            influences.mBones[i] = 0;
+        }
+    }
+    const std::vector<aiVector3D> srcPositions = makeVectors(numVertices, rng);
+    const std::vector<aiVector3D> srcNormals = makeVectors(numVertices, rng);
+
+    for (SkinningKernel kernel : Kernels) {
+        if (!isSkinningKernelSupported(kernel)) {
+            continue;
+        }
+        SCOPED_TRACE(static_cast<int>(kernel));
+        std::vector<float> positions(numVertices * 3);
+        std::vector<float> normals(numVertices * 3);
+        skin(kernel, influences, palette, srcPositions, srcNormals, positions, normals, 0, numVertices);
+        for (size_t i = 0; i < numVertices * 3; ++i) {
+            EXPECT_TRUE(std::isfinite(positions[i])) << "component " << i;
+            EXPECT_TRUE(std::isfinite(normals[i])) << "component " << i;
+        }
+    }
+}
+
+TEST(Skinning, BuildBoneInfluencesKeepsTheStrongestBones) {
+    // one vertex influenced by six bones with weights 1..6
+    aiMesh mesh;
+    mesh.mNumVertices = 1;
+    mesh.mVertices = new aiVector3D[1];
+    mesh.mNumBones = 6;
+    mesh.mBones = new aiBone*[6];
+    for (unsigned b = 0; b < 6; ++b) {
+        mesh.mBones[b] = new aiBone();
+        mesh.mBones[b]->mNumWeights = 1;
+        mesh.mBones[b]->mWeights = new aiVertexWeight[1];
+        mesh.mBones[b]->mWeights[0].mVertexId = 0;
+        mesh.mBones[b]->mWeights[0].mWeight = static_cast<float>(b + 1);
+    }
+
+    const BoneInfluences influences = buildBoneInfluences(&mesh);
+    ASSERT_EQ(influences.getNumVertices(), 1u);
+    const float sum = 6.0f + 5.0f + 4.0f + 3.0f;
+    for (size_t i = 0; i < MaxBoneInfluences; ++i) {
+        EXPECT_EQ(influences.mBones[i], 5u - i);
+        EXPECT_FLOAT_EQ(influences.mWeights[i], (6.0f - i) / sum);
+    }
+}
+
+TEST(Skinning, KernelArgumentLeavesTheDefaultAlone) {
+    std::mt19937 rng(17);
+    const std::vector<aiMatrix4x4> palette = makePalette(4, rng);
+    const BoneInfluences influences = makeInfluences(8, palette.size(), rng);
+    const std::vector<aiVector3D> srcPositions = makeVectors(8, rng);
+    const std::vector<aiVector3D> srcNormals = makeVectors(8, rng);
+    std::vector<float> positions(8 * 3);
+    std::vector<float> normals(8 * 3);
+
+    const SkinningKernel previous = getSkinningKernel();
+    setSkinningKernel(SkinningKernel::Sse);
+    const SkinningKernel active = getSkinningKernel();
+    skin(SkinningKernel::Scalar, influences, palette, srcPositions, srcNormals, positions, normals, 0, 8);
+    EXPECT_EQ(getSkinningKernel(), active);
+    setSkinningKernel(previous);
+}
@@ -0,0 +1,228 @@
+/*
+ Copyright (C) Sitara Systems
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published
+ by the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+#include "AssimpLoader.h"
+#include "VertexAnimation.h"
+
+using namespace ci;
+using namespace sitara::assimp;
+
+namespace {
+    //! Loads \a path without GL resources.
+    AssimpLoaderRef loadModel(const fs::path& path) {
+        AssimpLoaderRef loader = AssimpLoader::create();
+        loader->setFilename(path);
+        loader->enableGpuResources(false);
+        loader->preloadModel();
+        loader->postloadModel();
+        return loader;
+    }
+
+    //! Loads the walk cycle of the example.
+    AssimpLoaderRef loadAstroboy() {
+        return loadModel(fs::path(SITARA_ASSIMP_PATH) / "examples" / "BasicAssimpExample" / "assets" / "astroboy_walk.dae");
+    }
+
+    //! A triangle without bones in node "Mover", which a one second clip translates from the
+    // origin to (2, 0, 0).  Its parent "Root" is turned 90 degrees about y, so in model space
+    // the triangle moves to (0, 0, -2) and its normal is (1, 0, 0).
+    const char* AnimatedNodeGltf = R"({
+        "asset": {"version": "2.0"},
+        "scene": 0,
+        "scenes": [{"nodes": [0]}],
+        "nodes": [
+            {"name": "Root", "rotation": [0, 0.70710678, 0, 0.70710678], "children": [1]},
+            {"name": "Mover", "mesh": 0}
+        ],
+        "meshes": [{"primitives": [{"attributes": {"POSITION": 0, "NORMAL": 1}, "indices": 2}]}],
+        "animations": [{
+            "channels": [{"sampler": 0, "target": {"node": 1, "path": "translation"}}],
+            "samplers": [{"input": 3, "output": 4, "interpolation": "LINEAR"}]
+        }],
+        "buffers": [{"byteLength": 112, "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAAAAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAABAAIAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAAEAAAAAAAAAAAA=="}],
+        "bufferViews": [
+            {"buffer": 0, "byteOffset": 0, "byteLength": 72},
+            {"buffer": 0, "byteOffset": 72, "byteLength": 6},
+            {"buffer": 0, "byteOffset": 80, "byteLength": 32}
+        ],
+        "accessors": [
+            {"bufferView": 0, "byteOffset": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0]},
+            {"bufferView": 0, "byteOffset": 36, "componentType": 5126, "count": 3, "type": "VEC3"},
+            {"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"},
+            {"bufferView": 2, "byteOffset": 0, "componentType": 5126, "count": 2, "type": "SCALAR", "min": [0], "max": [1]},
+            {"bufferView": 2, "byteOffset": 8, "componentType": 5126, "count": 2, "type": "VEC3"}
+        ]
+    })";
+}
+
+TEST(VertexAnimation, FramesSpanTheClipEvenly) {
+    AssimpLoaderRef loader = loadAstroboy();
+    ASSERT_GT(loader->getNumAnimations(), 0u);
+    const double duration = loader->getAnimationDuration(0);
+
+    // a rate that doesn't divide the duration still ends on the last frame, which vat.vert
+    // wraps to frame 0
+    VertexAnimationRef vat = VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(29.0f).normals(false));
+    ASSERT_GT(vat->getNumFrames(), 1u);
+    EXPECT_NEAR((vat->getNumFrames() - 1) / vat->getSampleRate(), duration, 1e-4);
+    EXPECT_NEAR(vat->getSampleRate(), 29.0f, 29.0f / (vat->getNumFrames() - 1));
+}
+
+TEST(VertexAnimation, BakedFramesMatchTheSkinnedMeshes) {
+    AssimpLoaderRef loader = loadAstroboy();
+    ASSERT_GT(loader->getNumAnimations(), 0u);
+    VertexAnimationRef vat = VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(10.0f));
+    ASSERT_EQ(vat->getNumMeshes(), loader->getNumMeshes());
+
+    loader->setSkinningKernel(SkinningKernel::Scalar);
+    loader->enableSkinning();
+    loader->enableAnimation();
+    loader->setAnimation(0);
+    const size_t frame = vat->getNumFrames() / 2;
+    loader->setTime(frame / static_cast<double>(vat->getSampleRate()));
+    loader->update();
+
+    for (size_t n = 0; n < loader->getNumMeshes(); ++n) {
+        const TriMeshRef triMesh = loader->getTriMesh(n);
+        const vec3* positions = triMesh->getPositions<3>();
+        for (size_t v = 0; v < triMesh->getNumVertices(); ++v) {
+            const vec3 baked = vat->getPosition(frame, vat->getMeshOffset(n) + v);
+            ASSERT_NEAR(baked.x, positions[v].x, 1e-3f);
+            ASSERT_NEAR(baked.y, positions[v].y, 1e-3f);
+            ASSERT_NEAR(baked.z, positions[v].z, 1e-3f);
+        }
+    }
+}
+
+TEST(VertexAnimation, BakesNodeAnimationOfRigidMeshes) {
+    const fs::path path = fs::temp_directory_path() / "sitara-assimp-vat-animated-node.gltf";
+    {
+        std::ofstream stream(path.string());
+        stream << AnimatedNodeGltf;
+    }
+    AssimpLoaderRef loader = loadModel(path);
+    fs::remove(path);
+    ASSERT_EQ(loader->getNumAnimations(), 1u);
+    ASSERT_EQ(loader->getNumMeshes(), 1u);
+    ASSERT_NE(loader->getMeshNode(0), InvalidNodeHandle);
+
+    VertexAnimationRef vat = VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(4.0f));
+    ASSERT_EQ(vat->getNumFrames(), 5u);
+
+    const quat rootOrientation = glm::angleAxis(glm::radians(90.0f), vec3(0, 1, 0));
+    const vec3* positions = loader->getTriMesh(0)->getPositions<3>();
+    const size_t last = vat->getNumFrames() - 1;
+    for (size_t v = 0; v < vat->getNumVertices(); ++v) {
+        const vec3 first = rootOrientation * positions[v];
+        const vec3 end = rootOrientation * (positions[v] + vec3(2, 0, 0));
+        for (int c = 0; c < 3; ++c) {
+            EXPECT_NEAR(vat->getPosition(0, v)[c], first[c], 1e-4f);
+            EXPECT_NEAR(vat->getPosition(last, v)[c], end[c], 1e-4f);
+            EXPECT_NEAR(vat->getNormal(last, v)[c], vec3(1, 0, 0)[c], 1e-4f);
+        }
+    }
+}
+
+TEST(VertexAnimation, BakeRestoresTheLoaderAndLeavesTheGlobalKernel) {
+    AssimpLoaderRef loader = loadAstroboy();
+    ASSERT_GT(loader->getNumAnimations(), 0u);
+    loader->setTime(0.25);
+    loader->disableAnimation();
+    loader->disableSkinning();
+    const SkinningKernel globalKernel = getSkinningKernel();
+
+    VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(5.0f).scalarSkinning());
+
+    EXPECT_EQ(loader->getAnimation(), 0u);
+    EXPECT_EQ(loader->getTime(), 0.25);
+    EXPECT_FALSE(loader->isAnimationEnabled());
+    EXPECT_FALSE(loader->isSkinningEnabled());
+    EXPECT_FALSE(loader->getSkinningKernel().has_value());
+    EXPECT_EQ(getSkinningKernel(), globalKernel);
+}
+
+TEST(VertexAnimation, SaveAndLoadRoundTrip) {
+    AssimpLoaderRef loader = loadAstroboy();
+    ASSERT_GT(loader->getNumAnimations(), 0u);
+    VertexAnimationRef vat = VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(5.0f).halfFloat());
+
+    const fs::path path = fs::temp_directory_path() / "sitara-assimp-vat-test.vat";
+    vat->save(path);
+    VertexAnimationRef loaded = VertexAnimation::load(path);
+    fs::remove(path);
+
+    ASSERT_EQ(loaded->getNumFrames(), vat->getNumFrames());
+    ASSERT_EQ(loaded->getNumVertices(), vat->getNumVertices());
+    EXPECT_EQ(loaded->getSampleRate(), vat->getSampleRate());
+    EXPECT_TRUE(loaded->isHalfFloat());
+    for (size_t frame = 0; frame < vat->getNumFrames(); ++frame) {
+        for (size_t v = 0; v < vat->getNumVertices(); v += 97) {
+            ASSERT_EQ(loaded->getPosition(frame, v), vat->getPosition(frame, v));
+            ASSERT_EQ(loaded->getNormal(frame, v), vat->getNormal(frame, v));
+        }
+    }
+}
+
+TEST(VertexAnimation, LoadRejectsTruncatedFiles) {
+    AssimpLoaderRef loader = loadAstroboy();
+    ASSERT_GT(loader->getNumAnimations(), 0u);
+    VertexAnimationRef vat = VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(5.0f));
+
+    const fs::path path = fs::temp_directory_path() / "sitara-assimp-vat-truncated.vat";
+    vat->save(path);
+    fs::resize_file(path, fs::file_size(path) - 1);
+    EXPECT_THROW(VertexAnimation::load(path), AssimpLoaderExc);
+    fs::remove(path);
+}
+
+TEST(VertexAnimation, LoadRejectsCorruptHeaders) {
+    AssimpLoaderRef loader = loadAstroboy();
+    ASSERT_GT(loader->getNumAnimations(), 0u);
+    VertexAnimationRef vat = VertexAnimation::bake(loader, 0, VertexAnimation::Format().sampleRate(5.0f).normals(false));
+
+    const fs::path path = fs::temp_directory_path() / "sitara-assimp-vat-corrupt.vat";
+    vat->save(path);
+
+    // overwrites one uint32 field of the header: the frame count at byte 12, the mesh count at 16
+    auto corrupt = [&path](std::streamoff offset, uint32_t value) {
+        std::fstream stream(path.string(), std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp(offset);
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    // sizes that wrap around or need far more data than the file holds throw before allocating
+    corrupt(16, 0xFFFFFFFFu);
+    EXPECT_THROW(VertexAnimation::load(path), AssimpLoaderExc);
+    corrupt(16, static_cast<uint32_t>(vat->getNumMeshes()));
+    corrupt(12, 0x7FFFFFFFu);
+    EXPECT_THROW(VertexAnimation::load(path), AssimpLoaderExc);
+
+    // the mesh offsets follow the 40 byte header; they have to start at 0 and ascend
+    corrupt(12, static_cast<uint32_t>(vat->getNumFrames()));
+    ASSERT_NO_THROW(VertexAnimation::load(path));
+    corrupt(40, 1);
+    EXPECT_THROW(VertexAnimation::load(path), AssimpLoaderExc);
+    corrupt(40, 0);
+    corrupt(44, 0xFFFFFFFFu);
+    EXPECT_THROW(VertexAnimation::load(path), AssimpLoaderExc);
+    fs::remove(path);
+}